@@ -2,6 +2,22 @@
 
 filename="paper-wallet"
 
+# Batch mode: typeset every wallet in wallets.tex into a single document
+if [ "$1" = "-b" ]; then
+  filename="paper-wallets"
+
+  xelatex "$filename" > /dev/null 2>&1
+  if [ "$?" -ne 0 ]; then
+    echo "Unable to compile $filename.tex"
+    exit 1
+  fi
+
+  rm -f $filename.aux
+  rm -f $filename.log
+  rm -f wallets.tex
+  exit 0
+fi
+
 if [ "$#" -ne 2 ]; then
   echo "$0 requires 2 arguments, $# provided"
   exit 1
@@ -0,0 +1,44 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <vector>  // std::vector
+
+#include <benchmark/benchmark.h>
+#include <gmpxx.h>
+
+namespace Bench {
+
+    /**
+     * Heap usage observed through the global `operator new` and the GMP memory
+     * functions, both of which are replaced by the benchmark binary.
+     */
+    struct Allocations {
+        std::uint64_t count;
+        std::uint64_t bytes;
+    };
+
+    Allocations allocations();
+
+    std::vector<mpz_class> randomScalars(const mpz_class& n, std::size_t count);
+
+    /**
+     * Reports ops/sec and allocations per op for the enclosing benchmark when
+     * it goes out of scope, where every iteration performs `items` ops.
+     * Construct it immediately before the timing loop so setup costs are
+     * excluded.
+     */
+    class Counters {
+    public:
+        Counters(benchmark::State& state, std::int64_t items = 1);
+        ~Counters();
+    private:
+        benchmark::State& state_;
+        std::int64_t items_;
+        Allocations start_;
+    };
+
+}
+
+#endif
@@ -0,0 +1,82 @@
+#include "bench.h"
+
+#include <memory> // std::unique_ptr
+
+#include "babygiant.h"
+
+using namespace Elliptic;
+
+namespace {
+
+    /**
+     * Curve with a precomputed (prime) order, since the naive `Curve::getOrder`
+     * is quadratic in p.
+     */
+    class OrderedCurve : public Curve {
+    public:
+        OrderedCurve(int a, int b, mpz_class prime, mpz_class order) :
+            Curve(a, b, prime), order_(order) {}
+
+        mpz_class getOrder() const { return order_; }
+    private:
+        mpz_class order_;
+    };
+
+    struct Parameters {
+        int b;
+        long prime, order, x, y;
+    };
+
+    // y^2 = x^3 + b (mod prime) with prime order and generator (x, y)
+    const Parameters CURVES[] = {
+        { 6, 1039, 1033, 2, 937 },
+        { 3, 16447, 16417, 2, 1512 },
+        { 2, 262147, 262657, 2, 103214 },
+        { 2, 4194403, 4190677, 2, 851392 }
+    };
+
+    const std::size_t SCALARS = 16;
+
+}
+
+static void BM_DiscreteLogarithm(benchmark::State& state) {
+    const Parameters& c = CURVES[state.range(0)];
+    OrderedCurve* curve = new OrderedCurve(0, c.b, c.prime, c.order);
+    BabyGiant babygiant = BabyGiant(std::unique_ptr<Curve>(curve));
+
+    Point G(c.x, c.y);
+    std::vector<Point> targets;
+    for (const mpz_class& k : Bench::randomScalars(c.order, SCALARS)) {
+        targets.push_back(curve->multiply(G, k));
+    }
+
+    state.SetLabel("n=" + std::to_string(c.order));
+
+    std::size_t i = 0;
+    Bench::Counters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(babygiant.discreteLogarithm(G, targets[i++ % SCALARS]));
+    }
+}
+BENCHMARK(BM_DiscreteLogarithm)->DenseRange(0, 3)->Unit(benchmark::kMillisecond);
+
+/**
+ * All SCALARS targets solved in one pass against the largest curve.
+ */
+static void BM_DiscreteLogarithmBatch(benchmark::State& state) {
+    const Parameters& c = CURVES[3];
+    OrderedCurve* curve = new OrderedCurve(0, c.b, c.prime, c.order);
+    BabyGiant babygiant = BabyGiant(std::unique_ptr<Curve>(curve));
+
+    Point G(c.x, c.y);
+    std::vector<Point> targets;
+    for (const mpz_class& k : Bench::randomScalars(c.order, SCALARS)) {
+        targets.push_back(curve->multiply(G, k));
+    }
+
+    Bench::Counters counters(state, SCALARS);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(babygiant.discreteLogarithm(G, targets));
+    }
+}
+BENCHMARK(BM_DiscreteLogarithmBatch)->Unit(benchmark::kMillisecond);
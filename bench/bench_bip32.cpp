@@ -0,0 +1,43 @@
+#include "bench.h"
+
+#include "bip32.h"
+
+using namespace Elliptic;
+
+namespace {
+
+    const std::string SEED = "000102030405060708090A0B0C0D0E0F";
+
+}
+
+/**
+ * One child at a time: HMAC plus a scalar multiplication per child.
+ */
+static void BM_Bip32Derive(benchmark::State& state) {
+    Bip32 bip32;
+    ExtendedKey xpub = bip32.neuter(bip32.derive(bip32.master(SEED), "m/44'/0'/0'/0"));
+    std::uint32_t count = state.range(0);
+
+    Bench::Counters counters(state, count);
+    for (auto _ : state) {
+        for (std::uint32_t i = 0; i < count; i++) {
+            benchmark::DoNotOptimize(bip32.derive(xpub, i));
+        }
+    }
+}
+BENCHMARK(BM_Bip32Derive)->Arg(256)->Unit(benchmark::kMillisecond);
+
+/**
+ * Range of children from the base table with batched additions.
+ */
+static void BM_Bip32DerivePublic(benchmark::State& state) {
+    Bip32 bip32;
+    ExtendedKey xpub = bip32.neuter(bip32.derive(bip32.master(SEED), "m/44'/0'/0'/0"));
+    std::uint32_t count = state.range(0);
+
+    Bench::Counters counters(state, count);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bip32.derivePublic(xpub, 0, count));
+    }
+}
+BENCHMARK(BM_Bip32DerivePublic)->Arg(256)->Unit(benchmark::kMillisecond);
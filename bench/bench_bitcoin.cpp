@@ -0,0 +1,175 @@
+#include "bench.h"
+
+#include <sstream> // std::istringstream, std::ostringstream
+#include <thread>  // std::thread
+
+#include "base58.h"
+#include "bitcoin.h"
+#include "cli.h"
+#include "recovery.h"
+#include "server.h"
+
+using namespace Elliptic;
+
+namespace {
+
+    const std::string PRIVATE_HEX = "0C28FCA386C7A227600B2FE50B7CAE11EC86D3BF1FBE471BE89827E19D72AA1D";
+    const std::string PUBLIC_KEY = "04D0DE0AAEAEFAD02B8BDC8A01A1B8B11C696BD3D66A2C5F10780D95B7DF42645CD85228A6FB29940E858E7E55842AE2BD115D1ED7CC0E82D934E929C97648CB0A";
+    const std::string ADDRESS_HEX = "00A65D1A239D4EC666643D350C7BB8FC44D2881128268E839B";
+
+}
+
+static void BM_HashSha256(benchmark::State& state) {
+    Bench::Counters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Hash::sha256(PUBLIC_KEY));
+    }
+}
+BENCHMARK(BM_HashSha256);
+
+static void BM_HashRipemd160(benchmark::State& state) {
+    std::string sha = Hash::sha256(PUBLIC_KEY);
+
+    Bench::Counters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Hash::ripemd160(sha));
+    }
+}
+BENCHMARK(BM_HashRipemd160);
+
+static void BM_Base58Encode(benchmark::State& state) {
+    Bench::Counters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Base58::hexToBase58(ADDRESS_HEX));
+    }
+}
+BENCHMARK(BM_Base58Encode);
+
+static void BM_Base58Decode(benchmark::State& state) {
+    std::string address = Base58::hexToBase58(ADDRESS_HEX);
+
+    Bench::Counters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Base58::base58ToHex(address));
+    }
+}
+BENCHMARK(BM_Base58Decode);
+
+static void BM_PrivateHexToPublicKey(benchmark::State& state) {
+    Bitcoin bitcoin;
+    bool compressed = state.range(0) != 0;
+
+    Bench::Counters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bitcoin.privateHexToPublicKey(PRIVATE_HEX, compressed));
+    }
+}
+BENCHMARK(BM_PrivateHexToPublicKey)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+static void BM_PublicKeyToAddress(benchmark::State& state) {
+    Bitcoin bitcoin;
+
+    Bench::Counters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bitcoin.publicKeyToAddress(PUBLIC_KEY));
+    }
+}
+BENCHMARK(BM_PublicKeyToAddress)->Unit(benchmark::kMicrosecond);
+
+static void BM_PrivateHexToWIF(benchmark::State& state) {
+    Bitcoin bitcoin;
+
+    Bench::Counters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bitcoin.privateHexToWIF(PRIVATE_HEX, false));
+    }
+}
+BENCHMARK(BM_PrivateHexToWIF)->Unit(benchmark::kMicrosecond);
+
+static void BM_GeneratePrivateHex(benchmark::State& state) {
+    Bitcoin bitcoin;
+    std::size_t count = state.range(0);
+
+    Bench::Counters counters(state, count);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bitcoin.generatePrivateHex(count));
+    }
+}
+BENCHMARK(BM_GeneratePrivateHex)->Arg(1)->Arg(1000);
+
+/**
+ * Full wallet derivation: private key -> public key -> address and WIF.
+ */
+static void BM_WalletChain(benchmark::State& state) {
+    Bitcoin bitcoin;
+    bool compressed = state.range(0) != 0;
+
+    Bench::Counters counters(state);
+    for (auto _ : state) {
+        std::string publicKey = bitcoin.privateHexToPublicKey(PRIVATE_HEX, compressed);
+        benchmark::DoNotOptimize(bitcoin.publicKeyToAddress(publicKey));
+        benchmark::DoNotOptimize(bitcoin.privateHexToWIF(PRIVATE_HEX, compressed));
+    }
+}
+BENCHMARK(BM_WalletChain)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Partial WIF recovery of two unreadable characters, filtered on the checksum.
+ */
+static void BM_RecoverWIF(benchmark::State& state) {
+    Recovery recovery("5HueCGU8rMjxEXxiPuD5BDku4Mk?qeZyd4dZ1jvhTVqvbTLvyT?");
+
+    Bench::Counters counters(state, recovery.getCandidates());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(recovery.search("", Recovery::Progress(), 1));
+    }
+}
+BENCHMARK(BM_RecoverWIF)->Unit(benchmark::kMillisecond);
+
+/**
+ * `elliptic derive -a` over n keys on `workers` threads per stage: batched
+ * base table multiplication in a pipeline against one key at a time above.
+ */
+static void BM_CliDerive(benchmark::State& state) {
+    std::size_t n = state.range(0);
+    unsigned workers = static_cast<unsigned>(state.range(1));
+
+    std::string input;
+    for (const std::string& key : Bitcoin().generatePrivateHex(n)) {
+        input += key + "\n";
+    }
+
+    std::vector<std::string> args = { "derive", "-a", "-t", std::to_string(workers) };
+    std::ostringstream err;
+    Bench::Counters counters(state, n);
+    for (auto _ : state) {
+        std::istringstream in(input);
+        std::ostringstream out;
+        Cli(in, out, err).run(args);
+        benchmark::DoNotOptimize(out.str().size());
+    }
+}
+BENCHMARK(BM_CliDerive)->Args({ 4096, 1 })->Args({ 4096, 4 })->UseRealTime()->Unit(benchmark::kMillisecond);
+
+/**
+ * Address requests through the local server from 8 connections keeping 64
+ * requests each in flight, with batches of at most `maxBatch` keys. Batches
+ * of one give the cost of serving every request on its own.
+ */
+static void BM_ServerLoad(benchmark::State& state) {
+    Server::Options options;
+    options.path = "bench_server.sock";
+    options.maxBatch = static_cast<std::size_t>(state.range(0));
+    Server server(options);
+    std::thread thread([&server]() { server.run(); });
+
+    const std::uint64_t requests = 8192;
+    Bench::Counters counters(state, requests);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ServerClient::load(options.path, 8, requests, 64).requests);
+    }
+
+    server.stop();
+    thread.join();
+}
+BENCHMARK(BM_ServerLoad)->Arg(1)->Arg(256)->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,283 @@
+#include "bench.h"
+
+#include "bitcoin.h"
+#include "field.h"
+#include "keyrange.h"
+#include "simd.h"
+
+using namespace Elliptic;
+
+namespace {
+
+    const std::size_t SCALARS = 64;
+
+    struct Fixture {
+        Secp256k1 curve;
+        Point G, twoG;
+
+        Fixture() : G(Bitcoin().getBasePoint()), twoG(curve.multiply(G)) {}
+    };
+
+    /**
+     * y^2 = x^3 + 7 over 2^607 - 1, wider than the field backends, so every
+     * operation takes the mpz_class fallback.
+     */
+    struct GenericFixture {
+        Curve curve;
+        Point G;
+
+        GenericFixture() : curve(0, 7, (mpz_class(1) << 607) - 1) {
+            for (mpz_class x = 1;; x++) {
+                mpz_class y = curve.squareRoot(x*x*x + 7);
+                if (curve.hasPoint(Point(x, y))) {
+                    G = Point(x, y);
+                    break;
+                }
+            }
+        }
+    };
+
+}
+
+static void BM_CurveAdd(benchmark::State& state) {
+    Fixture f;
+
+    Bench::Counters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(f.curve.add(f.G, f.twoG));
+    }
+}
+BENCHMARK(BM_CurveAdd);
+
+static void BM_CurveDouble(benchmark::State& state) {
+    Fixture f;
+
+    Bench::Counters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(f.curve.multiply(f.twoG));
+    }
+}
+BENCHMARK(BM_CurveDouble);
+
+static void BM_CurveMultiply(benchmark::State& state) {
+    Fixture f;
+    std::vector<mpz_class> scalars = Bench::randomScalars(f.curve.getOrder(), SCALARS);
+
+    std::size_t i = 0;
+    Bench::Counters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(f.curve.multiply(f.G, scalars[i++ % SCALARS]));
+    }
+}
+BENCHMARK(BM_CurveMultiply)->Unit(benchmark::kMicrosecond);
+
+static void BM_CurveInverse(benchmark::State& state) {
+    Fixture f;
+    std::vector<mpz_class> scalars = Bench::randomScalars(f.curve.getPrime(), SCALARS);
+
+    std::size_t i = 0;
+    Bench::Counters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(f.curve.inverse(scalars[i++ % SCALARS]));
+    }
+}
+BENCHMARK(BM_CurveInverse);
+
+static void BM_CurveSquareRoot(benchmark::State& state) {
+    Fixture f;
+
+    // y^2 = x^3 + 7 always has a square root for points on the curve
+    mpz_class P = f.curve.getPrime(), r;
+    mpz_powm_ui(r.get_mpz_t(), f.G.getX().get_mpz_t(), 3, P.get_mpz_t());
+    r += f.curve.getB();
+
+    Bench::Counters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(f.curve.squareRoot(r));
+    }
+}
+BENCHMARK(BM_CurveSquareRoot);
+
+/**
+ * Sum of n scalar multiples, one multiply per term versus a single MSM
+ * (Straus for small n, Pippenger for large n), on one or all threads.
+ */
+static void BM_CurveMultiScalar(benchmark::State& state) {
+    Fixture f;
+    std::size_t n = state.range(0);
+    bool msm = state.range(1) != 0;
+    unsigned workers = static_cast<unsigned>(state.range(2));
+
+    std::vector<mpz_class> scalars = Bench::randomScalars(f.curve.getOrder(), n);
+    std::vector<Point> points;
+    for (const mpz_class& k : Bench::randomScalars(f.curve.getOrder(), n)) {
+        points.push_back(f.curve.multiply(f.G, k));
+    }
+
+    Bench::Counters counters(state, n);
+    for (auto _ : state) {
+        if (msm) {
+            benchmark::DoNotOptimize(f.curve.multiply(points, scalars, workers));
+            continue;
+        }
+
+        Point sum;
+        for (std::size_t i = 0; i < n; i++) {
+            sum = f.curve.add(sum, f.curve.multiply(points[i], scalars[i]));
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(BM_CurveMultiScalar)
+    ->Args({ 8, 0, 1 })->Args({ 8, 1, 1 })
+    ->Args({ 256, 0, 1 })->Args({ 256, 1, 1 })->Args({ 256, 1, 4 })
+    ->Args({ 4096, 1, 1 })->Args({ 4096, 1, 4 })
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * n field multiplications at a time for each available SIMD level, against
+ * Field<4> one element at a time.
+ */
+static void BM_FieldMultiply(benchmark::State& state) {
+    Fixture f;
+    std::size_t n = state.range(0);
+    int level = static_cast<int>(state.range(1));
+    if (level > VectorField::best()) {
+        state.SkipWithError("SIMD level not supported by this CPU");
+        return;
+    }
+
+    std::vector<mpz_class> values = Bench::randomScalars(f.curve.getPrime(), 2*n);
+    if (level < 0) {
+        Field<4> field(f.curve.getPrime());
+        std::vector<Field<4>::Element> a, b, r(n);
+        for (std::size_t i = 0; i < n; i++) {
+            a.push_back(field.fromMpz(values[i]));
+            b.push_back(field.fromMpz(values[n + i]));
+        }
+
+        Bench::Counters counters(state, n);
+        for (auto _ : state) {
+            for (std::size_t i = 0; i < n; i++) {
+                field.multiply(r[i], a[i], b[i]);
+            }
+            benchmark::DoNotOptimize(r.data());
+        }
+        return;
+    }
+
+    VectorField field(f.curve.getPrime(), static_cast<VectorField::Level>(level));
+    std::vector<std::uint64_t> words(VectorField::WORDS*2*n);
+    for (std::size_t i = 0; i < 2*n; i++) {
+        mpz_export(&words[VectorField::WORDS*i], nullptr, -1, sizeof(std::uint64_t), 0, 0,
+            values[i].get_mpz_t());
+    }
+
+    VectorField::Vector a = field.vector(n), b = field.vector(n), r;
+    field.fromWords(a, words.data());
+    field.fromWords(b, &words[VectorField::WORDS*n]);
+
+    Bench::Counters counters(state, n);
+    for (auto _ : state) {
+        field.multiply(r, a, b);
+        benchmark::DoNotOptimize(r);
+    }
+}
+BENCHMARK(BM_FieldMultiply)
+    ->Args({ 1024, -1 })->Args({ 1024, VectorField::SCALAR })->Args({ 1024, VectorField::AVX2 })
+    ->Args({ 1024, VectorField::AVX512_IFMA })
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * Adds G to n points, one affine addition at a time versus batched, where the
+ * batch runs across SIMD lanes when the CPU has them.
+ */
+static void BM_CurveBatchAdd(benchmark::State& state) {
+    Fixture f;
+    std::size_t n = state.range(0);
+    bool batched = state.range(1) != 0;
+
+    std::vector<Point> points;
+    for (const mpz_class& k : Bench::randomScalars(f.curve.getOrder(), n)) {
+        points.push_back(f.curve.multiply(f.G, k));
+    }
+
+    Bench::Counters counters(state, n);
+    for (auto _ : state) {
+        std::vector<Point> sums = points;
+        if (batched) {
+            f.curve.add(sums, f.G);
+        } else {
+            for (Point& p : sums) {
+                p = f.curve.add(p, f.G);
+            }
+        }
+        benchmark::DoNotOptimize(sums.data());
+    }
+}
+BENCHMARK(BM_CurveBatchAdd)
+    ->Args({ 1024, 0 })->Args({ 1024, 1 })
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * Points of n consecutive keys, one scalar multiplication per key versus
+ * walking a KeyRange.
+ */
+static void BM_CurveKeyRange(benchmark::State& state) {
+    Fixture f;
+    std::size_t n = state.range(0);
+    bool walked = state.range(1) != 0;
+    mpz_class first = Bench::randomScalars(f.curve.getOrder() - n, 1)[0];
+
+    Bench::Counters counters(state, n);
+    for (auto _ : state) {
+        if (walked) {
+            KeyRange range(f.curve, f.G, first, n);
+            std::vector<Point> points;
+            while (range.next(points)) {
+                benchmark::DoNotOptimize(points.data());
+            }
+        } else {
+            for (std::size_t i = 0; i < n; i++) {
+                benchmark::DoNotOptimize(f.curve.multiply(f.G, first + i));
+            }
+        }
+    }
+}
+BENCHMARK(BM_CurveKeyRange)
+    ->Args({ 4096, 0 })->Args({ 4096, 1 })
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * Scalar multiplication and batched addition on the mpz_class fallback, where
+ * allocs/op shows how often the temporaries go through the heap.
+ */
+static void BM_CurveGenericMultiply(benchmark::State& state) {
+    GenericFixture f;
+    std::vector<mpz_class> scalars = Bench::randomScalars(f.curve.getPrime(), SCALARS);
+
+    std::size_t i = 0;
+    Bench::Counters counters(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(f.curve.multiply(f.G, scalars[i++ % SCALARS]));
+    }
+}
+BENCHMARK(BM_CurveGenericMultiply)->Unit(benchmark::kMicrosecond);
+
+static void BM_CurveGenericBatchAdd(benchmark::State& state) {
+    GenericFixture f;
+    std::size_t n = state.range(0);
+
+    std::vector<Point> points;
+    for (const mpz_class& k : Bench::randomScalars(f.curve.getPrime(), n)) {
+        points.push_back(f.curve.multiply(f.G, k + 1));
+    }
+
+    std::vector<Point> sums = points;
+    Bench::Counters counters(state, n);
+    for (auto _ : state) {
+        f.curve.add(sums, f.G);
+        benchmark::DoNotOptimize(sums.data());
+    }
+}
+BENCHMARK(BM_CurveGenericBatchAdd)->Arg(256)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,120 @@
+#include "bench.h"
+
+#include <atomic>  // std::atomic
+#include <cstdlib> // std::malloc, std::free
+#include <new>     // std::bad_alloc
+
+#include <gmp.h>
+
+#include "instrument.h"
+
+namespace {
+
+    std::atomic<std::uint64_t> allocationCount(0);
+    std::atomic<std::uint64_t> allocationBytes(0);
+
+    void* (*nextAllocate)(std::size_t);
+    void* (*nextReallocate)(void*, std::size_t, std::size_t);
+    void (*nextFree)(void*, std::size_t);
+
+    void record(std::size_t bytes) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocationBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void* gmpAllocate(std::size_t size) {
+        record(size);
+        return nextAllocate(size);
+    }
+
+    void* gmpReallocate(void* ptr, std::size_t oldSize, std::size_t size) {
+        record(size);
+        return nextReallocate(ptr, oldSize, size);
+    }
+
+}
+
+void* operator new(std::size_t size) {
+    record(size);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+// GCC flags free() in a replaced operator delete once it is inlined at -O2
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+#pragma GCC diagnostic pop
+
+Bench::Allocations Bench::allocations() {
+    return { allocationCount.load(std::memory_order_relaxed),
+        allocationBytes.load(std::memory_order_relaxed) };
+}
+
+Bench::Counters::Counters(benchmark::State& state, std::int64_t items) :
+        state_(state), items_(items) {
+    Elliptic::Instrument::reset();
+    start_ = allocations();
+}
+
+Bench::Counters::~Counters() {
+    Allocations end = allocations();
+
+    // Counts are averaged over iterations, then divided among their items
+    double items = static_cast<double>(items_);
+    state_.SetItemsProcessed(state_.iterations()*items_);
+    state_.counters["allocs/op"] = benchmark::Counter((end.count - start_.count) / items,
+        benchmark::Counter::kAvgIterations);
+    state_.counters["bytes/op"] = benchmark::Counter((end.bytes - start_.bytes) / items,
+        benchmark::Counter::kAvgIterations);
+
+    if (Elliptic::Instrument::enabled()) {
+        Elliptic::Instrument::Snapshot s = Elliptic::Instrument::snapshot();
+        for (int i = 0; i < Elliptic::Instrument::COUNTERS; i++) {
+            state_.counters[std::string(Elliptic::Instrument::COUNTER_NAMES[i]) + "/op"] =
+                benchmark::Counter(s.counters[i] / items, benchmark::Counter::kAvgIterations);
+        }
+    }
+}
+
+/**
+ * Uniform scalars in 1 to n - 1 from a fixed seed so that runs are comparable.
+ */
+std::vector<mpz_class> Bench::randomScalars(const mpz_class& n, std::size_t count) {
+    gmp_randclass random(gmp_randinit_mt);
+    random.seed(0xE11197C);
+
+    std::vector<mpz_class> scalars;
+    scalars.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+        scalars.push_back(random.get_z_range(n - 1) + 1);
+    }
+
+    return scalars;
+}
+
+int main(int argc, char** argv) {
+    mp_get_memory_functions(&nextAllocate, &nextReallocate, &nextFree);
+    mp_set_memory_functions(gmpAllocate, gmpReallocate, nextFree);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
@@ -0,0 +1,39 @@
+#ifndef ARITHMETIC_H
+#define ARITHMETIC_H
+
+#include <cstddef> // std::size_t
+#include <memory>  // std::unique_ptr
+#include <vector>  // std::vector
+
+#include "point.h"
+
+namespace Elliptic {
+
+    /**
+     * Point arithmetic backend of a curve y^2 = x^3 + ax + b (mod p). Points
+     * enter and leave in affine coordinates; implementations are free to work
+     * in any internal representation.
+     */
+    class Arithmetic {
+    public:
+        static const std::size_t MAX_LIMBS;
+
+        virtual ~Arithmetic() {}
+
+        static std::unique_ptr<Arithmetic> create(const mpz_class& a, const mpz_class& b,
+                const mpz_class& prime);
+
+        virtual bool hasPoint(const Point& p) const = 0;
+        virtual Point add(const Point& p, const Point& q) const = 0;
+        virtual Point twice(const Point& p) const = 0;
+        virtual Point multiply(const Point& p, const mpz_class& n) const = 0;
+        virtual Point multiply(const std::vector<Point>& points, const std::vector<mpz_class>& scalars,
+                unsigned workers) const = 0;
+
+        // p_i = p_i + q[i*stride], so a stride of zero adds the same point to all
+        virtual void add(std::vector<Point>& points, const Point* q, std::size_t stride) const = 0;
+    };
+
+}
+
+#endif
@@ -1,10 +1,14 @@
 #ifndef BABYGIANT_H
 #define BABYGIANT_H
 
-#include <memory>        // std::unique_ptr
-#include <unordered_map> // std::unordered_map
-#include <utility>       // std::move
-
+#include <cstddef>    // std::size_t
+#include <functional> // std::function
+#include <memory>     // std::unique_ptr
+#include <string>     // std::string
+#include <utility>    // std::move, std::pair
+#include <vector>     // std::vector
+
+#include "babysteptable.h"
 #include "curve.h"
 
 namespace Elliptic {
@@ -14,17 +18,43 @@ namespace Elliptic {
         BabyGiant(std::unique_ptr<Curve> curve) : curve_(std::move(curve)) {}
 
         mpz_class discreteLogarithm(const Point& G, const Point& P);
+        std::vector<mpz_class> discreteLogarithm(const Point& G, const std::vector<Point>& P);
+        std::vector<std::size_t> discreteLogarithm(const Point& G, const std::vector<Point>& P,
+                const std::function<void(std::size_t, const mpz_class&)>& resolved);
+
+        void loadTable(const std::string& path);
+        void saveTable(const Point& G, const std::string& path);
     private:
+        typedef std::pair<mpz_class, unsigned long> Factor; // (prime, exponent)
+
         static const long MEMORY_LIMIT;
+        static const std::size_t TABLE_CACHE;
+        static const unsigned long TRIAL_DIVISION, RHO_ITERATIONS;
+
         static mpz_class getRandom(mpz_class n);
+        static mpz_class getStepSize(const mpz_class& n);
+        static std::vector<Factor> factor(mpz_class n);
+        static mpz_class findFactor(const mpz_class& n);
 
         std::unique_ptr<Curve> curve_;
-
-        void populateTable(std::unordered_map<Point, long, PointHasher>& table,
-                const Point& G, mpz_class m);
+        std::vector<std::unique_ptr<BabyStepTable>> tables_;
+        mpz_class order_;
+        std::vector<Factor> factors_;
+
+        std::vector<std::size_t> solve(const Point& G, const mpz_class& n,
+                const std::vector<Point>& P,
+                const std::function<void(std::size_t, const mpz_class&)>& resolved);
+        std::vector<std::size_t> pohligHellman(const Point& G, const std::vector<Point>& P,
+                const std::function<void(std::size_t, const mpz_class&)>& resolved);
+
+        Point multiply(const Point& p, const mpz_class& k);
+
+        mpz_class getOrder();
+        const std::vector<Factor>& getFactors();
+        const BabyStepTable& getTable(const Point& G, const mpz_class& m);
+        const BabyStepTable& cacheTable(std::unique_ptr<BabyStepTable> table);
     };
 
 }
 
 #endif
-
@@ -0,0 +1,60 @@
+#ifndef BABYSTEPTABLE_H
+#define BABYSTEPTABLE_H
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <string>  // std::string
+#include <utility> // std::pair
+#include <vector>  // std::vector
+
+#include "curve.h"
+
+namespace Elliptic {
+
+    /**
+     * Baby steps { jG | 1 <= j <= size } stored as (fingerprint, j) pairs sorted
+     * by a 64-bit fingerprint of the point. Tables are either built in memory or
+     * memory-mapped read-only from a file written by `save`, and are keyed by the
+     * curve parameters, the base point G and the giant step size m.
+     */
+    class BabyStepTable {
+    public:
+        struct Entry {
+            std::uint64_t fingerprint;
+            std::uint64_t j;
+        };
+
+        BabyStepTable(const Curve& curve, const Point& G, const mpz_class& m, long size);
+        BabyStepTable(const std::string& path);
+        ~BabyStepTable();
+
+        BabyStepTable(const BabyStepTable&) = delete;
+        BabyStepTable& operator=(const BabyStepTable&) = delete;
+
+        std::size_t size() const { return size_; }
+        bool matches(const Curve& curve, const Point& G, const mpz_class& m) const;
+        bool matches(const Curve& curve) const;
+
+        std::pair<const Entry*, const Entry*> find(const Point& Q) const;
+
+        void save(const std::string& path) const;
+    private:
+        static const char MAGIC[8];
+
+        std::string key_;
+        std::vector<Entry> entries_;
+
+        const Entry* begin_;
+        std::size_t size_;
+
+        void* mapping_;
+        std::size_t mappingLength_;
+
+        static std::uint64_t fingerprint(const Point& p);
+        static std::string curveKey(const Curve& curve);
+        static std::string makeKey(const Curve& curve, const Point& G, const mpz_class& m);
+    };
+
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef BASETABLE_H
+#define BASETABLE_H
+
+#include <cstddef> // std::size_t
+#include <vector>  // std::vector
+
+#include "curve.h"
+
+namespace Elliptic {
+
+    /**
+     * Precomputed multiples d 16^i G (1 <= d <= 15) of a fixed base point so that
+     * kG costs at most one point addition per 4-bit window of k and no
+     * doublings. Batches of scalars share one inversion per window.
+     */
+    class BaseTable {
+    public:
+        BaseTable(const Curve& curve, const Point& G);
+
+        Point multiply(const mpz_class& k) const;
+        std::vector<Point> multiply(const std::vector<mpz_class>& k) const;
+    private:
+        static const int WINDOW;
+
+        const Curve& curve_;
+        Point G_;
+        std::size_t windows_;
+        std::vector<Point> table_;
+
+        const Point& entry(std::size_t window, const mpz_class& k) const;
+    };
+
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef BIP32_H
+#define BIP32_H
+
+#include <atomic>        // std::atomic
+#include <cstddef>       // std::size_t
+#include <cstdint>       // std::uint32_t
+#include <list>          // std::list
+#include <mutex>         // std::mutex
+#include <string>        // std::string
+#include <unordered_map> // std::unordered_map
+#include <utility>       // std::pair
+#include <vector>        // std::vector
+
+#include "basetable.h"
+#include "bitcoin.h"
+
+namespace Elliptic {
+
+    /**
+     * BIP32 extended key. Private keys have a non-zero `privateKey`; the public
+     * key is always set.
+     */
+    struct ExtendedKey {
+        int depth;
+        std::uint32_t parentFingerprint;
+        std::uint32_t childNumber;
+        std::string chainCode; // 64 hexadecimal digits
+        mpz_class privateKey;
+        Point publicKey;
+
+        bool isPrivate() const { return sgn(privateKey) > 0; }
+    };
+
+    /**
+     * BIP32 hierarchical deterministic key derivation on secp256k1. Intermediate
+     * nodes of derived paths are kept in an LRU cache so that siblings such as
+     * m/44'/0'/0'/0/i only derive their last step, and ranges of non-hardened
+     * public children are computed with a precomputed table of multiples of G.
+     */
+    class Bip32 {
+    public:
+        static const std::uint32_t HARDENED;
+
+        Bip32(std::size_t cacheSize = 1024);
+
+        ExtendedKey master(const std::string& seed) const;
+        ExtendedKey derive(const ExtendedKey& parent, std::uint32_t index) const;
+        ExtendedKey derive(const ExtendedKey& root, const std::string& path);
+        ExtendedKey neuter(const ExtendedKey& key) const;
+
+        std::vector<Point> derivePublic(const ExtendedKey& parent, std::uint32_t first,
+                std::size_t count) const;
+        std::vector<std::string> deriveAddresses(const ExtendedKey& parent, std::uint32_t first,
+                std::size_t count) const;
+
+        std::string serialize(const ExtendedKey& key) const;
+        ExtendedKey parse(const std::string& extended) const;
+
+        std::size_t getCacheHits() const { return hits_; }
+    private:
+        static const std::string SEED_KEY, XPRV, XPUB;
+
+        Secp256k1 curve_;
+        Bitcoin bitcoin_;
+        BaseTable table_;
+
+        std::size_t cacheSize_;
+        std::list<std::pair<std::string, ExtendedKey>> cache_;
+        std::unordered_map<std::string, std::list<std::pair<std::string, ExtendedKey>>::iterator> index_;
+        std::mutex mutex_;
+        std::atomic<std::size_t> hits_;
+
+        bool findCached(const std::string& key, ExtendedKey& node);
+        void insertCached(const std::string& key, const ExtendedKey& node);
+
+        std::string childHmac(const ExtendedKey& parent, std::uint32_t index) const;
+        std::uint32_t fingerprint(const ExtendedKey& key) const;
+
+        static std::string toHex(const mpz_class& n, std::size_t length);
+    };
+
+}
+
+#endif
@@ -1,31 +1,47 @@
 #ifndef BITCOIN_H
 #define BITCOIN_H
 
-#include <memory> // std::unique_ptr
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <memory>  // std::unique_ptr
+#include <vector>  // std::vector
 
 #include "secp256k1.h"
 #include "hash.h"
+#include "keyrange.h"
 
 namespace Elliptic {
 
     class Bitcoin {
     public:
+        enum Renderer { LATEX, NATIVE };
+
         Bitcoin() : curve_(new Secp256k1()) {}
 
         Point getPoint(const std::string& point) const;
         Point getBasePoint() const { return getPoint(BASE_POINT); }
 
         void paperWallet(const std::string& privateKey, bool compressed) const;
+        void paperWallets(const std::vector<std::string>& privateKeys, bool compressed,
+                Renderer renderer = LATEX,
+                const std::string& path = "LaTeX/paper-wallets.pdf") const;
 
         std::string generatePrivateHex() const;
+        std::vector<std::string> generatePrivateHex(std::size_t count) const;
         std::string convertToPrivateHex(const std::string& privateKey) const;
         std::string privateHexToWIF(const std::string& privateKey, bool compressed) const;
         std::string privateHexToPublicKey(const std::string& privateKey, bool compressed) const;
+        std::string pointToPublicKey(const Point& p, bool compressed) const;
+        KeyRange keyRange(const std::string& privateKey, std::uint64_t count,
+                const mpz_class& stride = 1) const;
         std::string publicKeyToAddress(const std::string& publicKey) const;
+        std::string pointToAddress(const Point& p, bool compressed) const;
         std::string uncompressPublicKey(const std::string& compressed) const;
         std::string compressPublicKey(const std::string& uncompressed) const;
+
+        static std::string toUpperCase(std::string input);
     private:
-        static const int HEX_LENGTH, WIF_LENGTH, COMPRESSED, UNCOMPRESSED;
+        static const int HEX_LENGTH, WIF_LENGTH, COMPRESSED, UNCOMPRESSED, WALLETS_PER_PAGE;
         static const std::string BASE_POINT;
 
         std::unique_ptr<Curve> curve_;
@@ -35,10 +51,12 @@ namespace Elliptic {
         bool validWIF(const std::string& WIF) const;
 
         std::string WIFToPrivateHex(const std::string& WIF) const;
+        std::string encodeAddress(const std::string& publicKey) const;
 
+        static std::string drawWallet(const std::string& address, const std::string& WIF,
+                double y);
         static std::string diceToPrivateHex(const std::string& base6);
         static std::string pad(const std::string& input, std::size_t length);
-        static std::string toUpperCase(std::string input);
     };
 
 }
@@ -0,0 +1,68 @@
+#ifndef CLI_H
+#define CLI_H
+
+#include <cstddef> // std::size_t
+#include <istream> // std::istream
+#include <ostream> // std::ostream
+#include <string>  // std::string
+#include <vector>  // std::vector
+
+#include "basetable.h"
+#include "bitcoin.h"
+
+namespace Elliptic {
+
+    /**
+     * Streaming subcommands of the elliptic binary, see USAGE. Records are read
+     * one per line from a memory-mapped file or the input stream and pass in
+     * batches through a Pipeline of parsing, point multiplication and encoding
+     * stages, each on its own worker threads. Output line i answers input line
+     * i: blank lines give empty lines, and so do invalid records, which are
+     * also reported on the error stream with their line number.
+     */
+    class Cli {
+    public:
+        static const std::size_t BATCH;
+        static const char* const USAGE;
+
+        Cli(std::istream& in, std::ostream& out, std::ostream& err);
+
+        int run(const std::vector<std::string>& args);
+    private:
+        struct Options {
+            std::string command, path;
+            unsigned threads;
+            unsigned long long count;
+            bool compressed, address;
+            std::string socket;
+            unsigned long long batch, deadline, connections, depth;
+        };
+
+        struct Batch {
+            std::vector<std::size_t> lines; // Line number of every record
+            std::vector<std::string> records, output, errors;
+            std::vector<bool> blank; // Whitespace-only lines, skipped by every stage
+            std::vector<mpz_class> keys;
+            std::vector<Point> points;
+        };
+
+        std::istream& in_;
+        std::ostream& out_;
+        std::ostream& err_;
+
+        Secp256k1 curve_;
+        Bitcoin bitcoin_;
+        BaseTable table_;
+
+        static Options parse(const std::vector<std::string>& args);
+        bool stream(const Options& options);
+        void serve(const Options& options);
+        bool load(const Options& options);
+
+        template <class F>
+        static void each(Batch& batch, F f);
+    };
+
+}
+
+#endif
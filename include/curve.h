@@ -1,33 +1,52 @@
 #ifndef CURVE_H
 #define CURVE_H
 
+#include <memory> // std::shared_ptr
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include "arithmetic.h"
 #include "point.h"
 
 namespace Elliptic {
 
+    /**
+     * Curve y^2 = x^3 + ax + b (mod p) in affine coordinates. Odd primes of up to
+     * Arithmetic::MAX_LIMBS 64-bit limbs use a fixed-width Montgomery field
+     * backend chosen at construction; other primes use mpz_class arithmetic.
+     */
     class Curve {
     public:
-        Curve(int a, int b, mpz_class prime);
+        Curve(mpz_class a, mpz_class b, mpz_class prime);
         virtual ~Curve() {}
 
-        int getA() const { return a_; }
-        int getB() const { return b_; }
+        const mpz_class& getA() const { return a_; }
+        const mpz_class& getB() const { return b_; }
 
-        mpz_class getPrime() const { return prime_; }
+        const mpz_class& getPrime() const { return prime_; }
         virtual mpz_class getOrder() const;
 
         bool hasPoint(const Point& p) const;
         Point negatePoint(const Point &p) const;
 
-        Point add(Point p, Point q) const;
-        Point multiply(Point p) const;
-        Point multiply(Point p, mpz_class n) const;
+        Point add(const Point& p, const Point& q) const;
+        void add(std::vector<Point>& points, const Point& q) const;
+        void add(std::vector<Point>& points, const std::vector<Point>& q) const;
+        Point multiply(const Point& p) const;
+        Point multiply(const Point& p, const mpz_class& n) const;
+        Point multiply(const std::vector<Point>& points, const std::vector<mpz_class>& scalars,
+                unsigned workers = 1) const;
 
         mpz_class inverse(const mpz_class& op) const;
         mpz_class squareRoot(const mpz_class& op) const;
+    protected:
+        static mpz_class convertHex(const std::string& hexString);
     private:
-        int a_, b_;
-        mpz_class prime_;
+        mpz_class a_, b_, prime_;
+        std::shared_ptr<const Arithmetic> arithmetic_; // Null for the mpz_class fallback
+
+        template <class Q>
+        void addBatch(std::vector<Point>& points, Q q) const;
     };
 
 }
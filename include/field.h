@@ -0,0 +1,261 @@
+#ifndef FIELD_H
+#define FIELD_H
+
+#include <array>     // std::array
+#include <cstddef>   // std::size_t
+#include <cstdint>   // std::uint64_t
+#include <stdexcept> // std::invalid_argument
+#include <string>    // std::to_string
+
+#include <gmpxx.h>
+
+#include "instrument.h"
+
+namespace Elliptic {
+
+    /**
+     * Arithmetic modulo an odd prime p < 2^(64N) on fixed arrays of N 64-bit
+     * limbs (least significant first). Elements are kept in Montgomery form,
+     * aR mod p with R = 2^(64N), so a multiplication costs 2N^2 word
+     * multiplications and no division.
+     */
+    template <std::size_t N>
+    class Field {
+    public:
+        typedef std::array<std::uint64_t, N> Element;
+
+        explicit Field(const mpz_class& prime);
+
+        Element fromMpz(const mpz_class& op) const;
+        mpz_class toMpz(const Element& op) const;
+
+        const Element& zero() const { return zero_; }
+        const Element& one() const { return one_; }
+        const mpz_class& getPrime() const { return prime_; }
+
+        static bool isZero(const Element& op);
+
+        void add(Element& r, const Element& a, const Element& b) const;
+        void subtract(Element& r, const Element& a, const Element& b) const;
+        void multiply(Element& r, const Element& a, const Element& b) const;
+        void square(Element& r, const Element& a) const { multiply(r, a, a); }
+        void inverse(Element& r, const Element& a) const;
+    private:
+        static const int WINDOW = 4;
+
+        mpz_class prime_;
+        Element p_, zero_, one_, r2_, exponent_; // exponent = p - 2
+        std::size_t windows_;                    // 4-bit windows of the exponent
+        std::uint64_t inv_;                      // -p^-1 mod 2^64
+
+        static Element toLimbs(const mpz_class& op);
+        static mpz_class fromLimbs(const Element& op);
+        void reduce(Element& op, std::uint64_t carry) const;
+    };
+
+    template <std::size_t N>
+    Field<N>::Field(const mpz_class& prime) : prime_(prime) {
+        if (sgn(prime) <= 0 || mpz_even_p(prime.get_mpz_t()) || mpz_sizeinbase(prime.get_mpz_t(), 2) > 64*N) {
+            throw std::invalid_argument("Field requires an odd prime of at most " + std::to_string(64*N) + " bits");
+        }
+
+        p_ = toLimbs(prime);
+        zero_.fill(0);
+        exponent_ = toLimbs(prime - 2);
+        windows_ = (mpz_sizeinbase(prime.get_mpz_t(), 2) + WINDOW - 1)/WINDOW;
+
+        // Newton iteration for p^-1 mod 2^64, doubling the correct bits each step
+        std::uint64_t inv = 1;
+        for (int i = 0; i < 6; i++) {
+            inv *= 2 - p_[0]*inv;
+        }
+        inv_ = -inv;
+
+        mpz_class R;
+        mpz_setbit(R.get_mpz_t(), 64*N);
+        one_ = toLimbs(R % prime);
+        r2_ = toLimbs(R*R % prime);
+    }
+
+    /**
+     * Converts an integer to Montgomery form, reducing it mod p first.
+     */
+    template <std::size_t N>
+    typename Field<N>::Element Field<N>::fromMpz(const mpz_class& op) const {
+        Element a;
+        if (sgn(op) < 0 || cmp(op, prime_) >= 0) {
+            mpz_class reduced;
+            mpz_mod(reduced.get_mpz_t(), op.get_mpz_t(), prime_.get_mpz_t());
+            a = toLimbs(reduced);
+        } else {
+            a = toLimbs(op);
+        }
+
+        multiply(a, a, r2_);
+        return a;
+    }
+
+    template <std::size_t N>
+    mpz_class Field<N>::toMpz(const Element& op) const {
+        Element a, unit = zero_;
+        unit[0] = 1;
+        multiply(a, op, unit);
+        return fromLimbs(a);
+    }
+
+    template <std::size_t N>
+    bool Field<N>::isZero(const Element& op) {
+        std::uint64_t bits = 0;
+        for (std::size_t i = 0; i < N; i++) {
+            bits |= op[i];
+        }
+
+        return bits == 0;
+    }
+
+    template <std::size_t N>
+    void Field<N>::add(Element& r, const Element& a, const Element& b) const {
+        unsigned __int128 carry = 0;
+        #pragma GCC unroll 9
+        for (std::size_t i = 0; i < N; i++) {
+            carry += static_cast<unsigned __int128>(a[i]) + b[i];
+            r[i] = static_cast<std::uint64_t>(carry);
+            carry >>= 64;
+        }
+
+        reduce(r, static_cast<std::uint64_t>(carry));
+    }
+
+    template <std::size_t N>
+    void Field<N>::subtract(Element& r, const Element& a, const Element& b) const {
+        unsigned __int128 borrow = 0;
+        #pragma GCC unroll 9
+        for (std::size_t i = 0; i < N; i++) {
+            borrow = static_cast<unsigned __int128>(a[i]) - b[i] - borrow;
+            r[i] = static_cast<std::uint64_t>(borrow);
+            borrow = (borrow >> 64) & 1;
+        }
+
+        if (borrow != 0) {
+            unsigned __int128 carry = 0;
+            #pragma GCC unroll 9
+            for (std::size_t i = 0; i < N; i++) {
+                carry += static_cast<unsigned __int128>(r[i]) + p_[i];
+                r[i] = static_cast<std::uint64_t>(carry);
+                carry >>= 64;
+            }
+        }
+    }
+
+    /**
+     * Montgomery multiplication r = abR^-1 mod p, coarsely integrated operand
+     * scanning (CIOS). r may alias a or b.
+     */
+    template <std::size_t N>
+    void Field<N>::multiply(Element& r, const Element& a, const Element& b) const {
+        ELLIPTIC_COUNT(FIELD_MULTIPLICATIONS);
+        std::uint64_t t[N + 2] = {};
+        #pragma GCC unroll 9
+        for (std::size_t i = 0; i < N; i++) {
+            unsigned __int128 c = 0;
+            #pragma GCC unroll 9
+            for (std::size_t j = 0; j < N; j++) {
+                c += static_cast<unsigned __int128>(a[j])*b[i] + t[j];
+                t[j] = static_cast<std::uint64_t>(c);
+                c >>= 64;
+            }
+
+            c += t[N];
+            t[N] = static_cast<std::uint64_t>(c);
+            t[N + 1] = static_cast<std::uint64_t>(c >> 64);
+
+            // Add mp so the lowest word becomes zero, then shift down a word
+            std::uint64_t m = t[0]*inv_;
+            c = static_cast<unsigned __int128>(m)*p_[0] + t[0];
+            c >>= 64;
+            #pragma GCC unroll 9
+            for (std::size_t j = 1; j < N; j++) {
+                c += static_cast<unsigned __int128>(m)*p_[j] + t[j];
+                t[j - 1] = static_cast<std::uint64_t>(c);
+                c >>= 64;
+            }
+
+            c += t[N];
+            t[N - 1] = static_cast<std::uint64_t>(c);
+            t[N] = t[N + 1] + static_cast<std::uint64_t>(c >> 64);
+        }
+
+        for (std::size_t i = 0; i < N; i++) {
+            r[i] = t[i];
+        }
+
+        reduce(r, t[N]);
+    }
+
+    /**
+     * Inverse by Fermat's little theorem, a^(p-2), with a fixed 4-bit window.
+     * The inverse of zero is zero.
+     */
+    template <std::size_t N>
+    void Field<N>::inverse(Element& r, const Element& a) const {
+        Element table[1 << WINDOW];
+        table[0] = one_;
+        for (int i = 1; i < (1 << WINDOW); i++) {
+            multiply(table[i], table[i - 1], a);
+        }
+
+        Element result = one_;
+        for (std::size_t i = windows_; i-- > 0;) {
+            for (int s = 0; s < WINDOW; s++) {
+                square(result, result);
+            }
+
+            std::size_t bit = i*WINDOW;
+            unsigned digit = (exponent_[bit/64] >> (bit % 64)) & ((1 << WINDOW) - 1);
+            multiply(result, result, table[digit]);
+        }
+
+        r = result;
+    }
+
+    template <std::size_t N>
+    typename Field<N>::Element Field<N>::toLimbs(const mpz_class& op) {
+        Element a;
+        a.fill(0);
+        mpz_export(a.data(), nullptr, -1, sizeof(std::uint64_t), 0, 0, op.get_mpz_t());
+        return a;
+    }
+
+    template <std::size_t N>
+    mpz_class Field<N>::fromLimbs(const Element& op) {
+        mpz_class a;
+        mpz_import(a.get_mpz_t(), N, -1, sizeof(std::uint64_t), 0, 0, op.data());
+        return a;
+    }
+
+    /**
+     * Subtracts p from carry 2^(64N) + op < 2p if the result is not negative,
+     * selecting the result without branching on its value.
+     */
+    template <std::size_t N>
+    void Field<N>::reduce(Element& op, std::uint64_t carry) const {
+        Element difference;
+        unsigned __int128 borrow = 0;
+        #pragma GCC unroll 9
+        for (std::size_t i = 0; i < N; i++) {
+            borrow = static_cast<unsigned __int128>(op[i]) - p_[i] - borrow;
+            difference[i] = static_cast<std::uint64_t>(borrow);
+            borrow = (borrow >> 64) & 1;
+        }
+
+        // Keep op only if it was below p, i.e., borrowed without a carry
+        std::uint64_t keep = -static_cast<std::uint64_t>(borrow & (carry == 0));
+        #pragma GCC unroll 9
+        for (std::size_t i = 0; i < N; i++) {
+            op[i] = (op[i] & keep) | (difference[i] & ~keep);
+        }
+    }
+
+}
+
+#endif
@@ -11,11 +11,14 @@ namespace Elliptic {
     class Hash {
     public:
         static std::string sha256(const std::string& input);
+        static void sha256(const std::uint8_t* input, std::size_t length, std::uint8_t* output);
         static std::string ripemd160(const std::string& input);
+        static std::string hmacSha512(const std::string& key, const std::string& input);
         static std::string getRandom(std::size_t bytes);
+
+        static std::string byteToHex(const std::uint8_t* input, std::size_t length);
     private:
         static std::vector<std::uint8_t> hexToByte(const std::string& input);
-        static std::string byteToHex(std::uint8_t* input, std::size_t length);
     };
 
 }
@@ -0,0 +1,83 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <cstdint> // std::uint64_t
+
+#ifdef ELLIPTIC_INSTRUMENT
+#include <atomic>  // std::atomic
+#include <chrono>  // std::chrono::steady_clock
+#endif
+
+namespace Elliptic {
+
+    /**
+     * Optional operation counters and per-stage timers. Everything is compiled
+     * out unless ELLIPTIC_INSTRUMENT is defined (`make INSTRUMENT=1`); without
+     * it `snapshot` and `reset` still exist but always report zeros.
+     * SCALAR_MULTIPLICATIONS counts calls of Curve::multiply with a scalar,
+     * single or multi-scalar. FIELD_MULTIPLICATIONS counts multiplications and
+     * squarings mod p in every field backend, including those of Fermat
+     * inversions except on the mpz_class fallback, where GMP exponentiates.
+     * ALLOCATED_BYTES covers GMP allocations only, through its memory function
+     * hook; the benchmarks count operator new separately as bytes/op.
+     */
+    namespace Instrument {
+
+        enum Counter {
+            INVERSIONS, SCALAR_MULTIPLICATIONS, FIELD_MULTIPLICATIONS, ADDITIONS, DOUBLINGS,
+            HASHES, ENCODES, ALLOCATED_BYTES, COUNTERS
+        };
+
+        enum Stage {
+            GENERATE, CONVERT, PUBLIC_KEY, ADDRESS, WIF, RENDER, BABY_STEPS,
+            GIANT_STEPS, STAGES
+        };
+
+        extern const char* const COUNTER_NAMES[COUNTERS];
+        extern const char* const STAGE_NAMES[STAGES];
+
+        struct Snapshot {
+            std::uint64_t counters[COUNTERS];
+            std::uint64_t calls[STAGES];
+            std::uint64_t nanoseconds[STAGES];
+        };
+
+        bool enabled();
+        Snapshot snapshot();
+        void reset();
+
+#ifdef ELLIPTIC_INSTRUMENT
+        extern std::atomic<std::uint64_t> counters[COUNTERS];
+
+        inline void count(Counter counter, std::uint64_t n = 1) {
+            counters[counter].fetch_add(n, std::memory_order_relaxed);
+        }
+
+        class Timer {
+        public:
+            Timer(Stage stage) : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+            ~Timer();
+        private:
+            Stage stage_;
+            std::chrono::steady_clock::time_point start_;
+        };
+#endif
+
+    }
+
+}
+
+#ifdef ELLIPTIC_INSTRUMENT
+#define ELLIPTIC_COUNT(counter) \
+    Elliptic::Instrument::count(Elliptic::Instrument::counter)
+#define ELLIPTIC_COUNT_N(counter, n) \
+    Elliptic::Instrument::count(Elliptic::Instrument::counter, n)
+#define ELLIPTIC_TIMER(stage) \
+    Elliptic::Instrument::Timer elliptic_timer_##stage(Elliptic::Instrument::stage)
+#else
+#define ELLIPTIC_COUNT(counter) ((void) 0)
+#define ELLIPTIC_COUNT_N(counter, n) ((void) 0)
+#define ELLIPTIC_TIMER(stage) ((void) 0)
+#endif
+
+#endif
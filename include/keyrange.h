@@ -0,0 +1,50 @@
+#ifndef KEYRANGE_H
+#define KEYRANGE_H
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <vector>  // std::vector
+
+#include "curve.h"
+
+namespace Elliptic {
+
+    /**
+     * The keys first, first + stride, ..., first + (count - 1) stride and their
+     * multiples of G, walked in order. Up to BATCH consecutive points are kept
+     * as lanes which all advance by BATCH stride G in one batched addition, so
+     * a key costs about one affine point addition, plus a share of a single
+     * inversion, instead of a scalar multiplication. Ranges split into
+     * disjoint subranges that can be walked on separate threads.
+     */
+    class KeyRange {
+    public:
+        static const std::size_t BATCH;
+
+        KeyRange(const Curve& curve, const Point& G, const mpz_class& first, std::uint64_t count,
+                const mpz_class& stride = 1);
+
+        const mpz_class& getFirst() const { return first_; }
+        const mpz_class& getStride() const { return stride_; }
+        std::uint64_t size() const { return count_; }
+        std::uint64_t position() const { return position_; }
+
+        mpz_class key(std::uint64_t i) const { return first_ + stride_*i; }
+
+        bool next(std::vector<Point>& points);
+        std::vector<KeyRange> split(unsigned parts) const;
+    private:
+        const Curve& curve_;
+        Point G_;
+        mpz_class first_, stride_;
+        std::uint64_t count_, position_;
+
+        std::vector<Point> lanes_; // Points of the keys from position_ on
+        Point step_;               // lanes_.size() stride G
+
+        void start();
+    };
+
+}
+
+#endif
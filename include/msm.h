@@ -0,0 +1,214 @@
+#ifndef MSM_H
+#define MSM_H
+
+#include <algorithm> // std::max
+#include <cstddef>   // std::size_t
+#include <cstdint>   // std::uint64_t
+#include <stdexcept> // std::invalid_argument
+#include <vector>    // std::vector
+
+#include "parallel.h"
+#include "point.h"
+
+namespace Elliptic {
+
+    /**
+     * Multi-scalar multiplication, k_0 P_0 + ... + k_{n-1} P_{n-1}, generic over
+     * a point group providing
+     *
+     *     typedef ... Element;              // Accumulator, e.g., Jacobian
+     *     typedef ... Base;                 // Input point, e.g., affine
+     *     Element identity() const;
+     *     Base fromPoint(const Point&) const;
+     *     Element fromBase(const Base&) const;
+     *     Point toPoint(const Element&) const;
+     *     void add(Element&, const Element&) const;
+     *     void add(Element&, const Base&) const;
+     *     void twice(Element&) const;
+     *
+     * Straus' interleaved 4-bit windows are used for small n and Pippenger's
+     * bucket method for large n, whichever needs fewer group operations.
+     */
+    namespace Msm {
+
+        const unsigned STRAUS_WINDOW = 4;
+
+        /**
+         * Non-negative scalars as fixed-width little-endian 64-bit words.
+         */
+        class Scalars {
+        public:
+            Scalars(const std::vector<mpz_class>& scalars) : bits_(1) {
+                for (const mpz_class& k : scalars) {
+                    if (sgn(k) < 0) {
+                        throw std::invalid_argument("Scalars must not be negative");
+                    }
+
+                    bits_ = std::max(bits_, mpz_sizeinbase(k.get_mpz_t(), 2));
+                }
+
+                words_ = (bits_ + 63)/64 + 1; // Spare word for digits past the top
+                data_.assign(scalars.size()*words_, 0);
+                for (std::size_t i = 0; i < scalars.size(); i++) {
+                    mpz_export(&data_[i*words_], nullptr, -1, sizeof(std::uint64_t), 0, 0,
+                        scalars[i].get_mpz_t());
+                }
+            }
+
+            std::size_t getBits() const { return bits_; }
+
+            unsigned digit(std::size_t i, std::size_t bit, unsigned width) const {
+                const std::uint64_t* k = &data_[i*words_ + bit/64];
+                std::uint64_t value = k[0] >> (bit % 64);
+                if (bit % 64 != 0) {
+                    value |= k[1] << (64 - bit % 64);
+                }
+
+                return static_cast<unsigned>(value & ((std::uint64_t(1) << width) - 1));
+            }
+        private:
+            std::size_t bits_, words_;
+            std::vector<std::uint64_t> data_;
+        };
+
+        /**
+         * Group operations for Straus: 14 additions per point for the table of
+         * multiples, then one doubling per bit and one addition per point and
+         * window.
+         */
+        inline std::size_t strausCost(std::size_t n, std::size_t bits) {
+            return 14*n + bits + (bits + STRAUS_WINDOW - 1)/STRAUS_WINDOW*n;
+        }
+
+        /**
+         * Pippenger window width minimizing n + 2^(c+1) additions per window.
+         */
+        inline unsigned pippengerWindow(std::size_t n, std::size_t bits, std::size_t& cost) {
+            unsigned best = 1;
+            cost = static_cast<std::size_t>(-1);
+            for (unsigned c = 1; c <= 20; c++) {
+                std::size_t windowCost = bits + (bits + c - 1)/c*(n + (std::size_t(2) << c));
+                if (windowCost < cost) {
+                    cost = windowCost;
+                    best = c;
+                }
+            }
+
+            return best;
+        }
+
+        template <class Group>
+        typename Group::Element straus(const Group& group, const std::vector<typename Group::Base>& points,
+                const Scalars& scalars) {
+            typedef typename Group::Element Element;
+
+            const unsigned digits = (1 << STRAUS_WINDOW) - 1;
+            std::vector<Element> table;
+            table.reserve(points.size()*digits);
+            for (const typename Group::Base& p : points) {
+                Element multiple = group.fromBase(p);
+                for (unsigned d = 1; d <= digits; d++) {
+                    table.push_back(multiple);
+                    group.add(multiple, p);
+                }
+            }
+
+            Element q = group.identity();
+            std::size_t windows = (scalars.getBits() + STRAUS_WINDOW - 1)/STRAUS_WINDOW;
+            for (std::size_t w = windows; w-- > 0;) {
+                for (unsigned s = 0; s < STRAUS_WINDOW; s++) {
+                    group.twice(q);
+                }
+
+                for (std::size_t i = 0; i < points.size(); i++) {
+                    unsigned d = scalars.digit(i, w*STRAUS_WINDOW, STRAUS_WINDOW);
+                    if (d != 0) {
+                        group.add(q, table[i*digits + d - 1]);
+                    }
+                }
+            }
+
+            return q;
+        }
+
+        /**
+         * Every window of c bits is independent: each point is added to the
+         * bucket of its digit and the buckets are summed as
+         * sum_d d B_d = B_top + (B_top + B_{top-1}) + ..., so windows run in
+         * parallel and are combined with c doublings each at the end.
+         */
+        template <class Group>
+        typename Group::Element pippenger(const Group& group, const std::vector<typename Group::Base>& points,
+                const Scalars& scalars, unsigned c, unsigned workers) {
+            typedef typename Group::Element Element;
+
+            std::size_t windows = (scalars.getBits() + c - 1)/c;
+            std::vector<Element> sums(windows, group.identity());
+            Parallel::forEach(windows, [&](std::size_t w) {
+                std::vector<Element> buckets((std::size_t(1) << c) - 1, group.identity());
+                for (std::size_t i = 0; i < points.size(); i++) {
+                    unsigned d = scalars.digit(i, w*c, c);
+                    if (d != 0) {
+                        group.add(buckets[d - 1], points[i]);
+                    }
+                }
+
+                Element running = group.identity();
+                for (std::size_t d = buckets.size(); d-- > 0;) {
+                    group.add(running, buckets[d]);
+                    group.add(sums[w], running);
+                }
+            }, workers);
+
+            Element q = sums[windows - 1];
+            for (std::size_t w = windows - 1; w-- > 0;) {
+                for (unsigned s = 0; s < c; s++) {
+                    group.twice(q);
+                }
+
+                group.add(q, sums[w]);
+            }
+
+            return q;
+        }
+
+        /**
+         * Computes the sum of scalars[i] points[i] using up to `workers` threads.
+         * Scalars must not be negative; zero scalars and identity points are
+         * skipped.
+         */
+        template <class Group>
+        Point multiply(const Group& group, const std::vector<Point>& points,
+                const std::vector<mpz_class>& scalars, unsigned workers) {
+            if (points.size() != scalars.size()) {
+                throw std::invalid_argument("Multi-scalar multiplication requires a scalar per point");
+            }
+
+            std::vector<typename Group::Base> bases;
+            std::vector<mpz_class> nonzero;
+            for (std::size_t i = 0; i < points.size(); i++) {
+                if (sgn(scalars[i]) != 0 && !points[i].isZero()) { // Negative scalars throw in Scalars
+                    bases.push_back(group.fromPoint(points[i]));
+                    nonzero.push_back(scalars[i]);
+                }
+            }
+
+            if (bases.empty()) {
+                return Point();
+            }
+
+            Scalars k(nonzero);
+            std::size_t pippengerCost;
+            unsigned c = pippengerWindow(bases.size(), k.getBits(), pippengerCost);
+            if (strausCost(bases.size(), k.getBits()) <= pippengerCost) {
+                return group.toPoint(straus(group, bases, k));
+            }
+
+            return group.toPoint(pippenger(group, bases, k, c, workers));
+        }
+
+    }
+
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm> // std::min
+#include <atomic>    // std::atomic
+#include <cstddef>   // std::size_t
+#include <exception> // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <mutex>     // std::mutex, std::lock_guard
+#include <thread>    // std::thread
+#include <vector>    // std::vector
+
+namespace Elliptic {
+
+    namespace Parallel {
+
+        /**
+         * Number of worker threads to use, at least one.
+         */
+        inline unsigned threads() {
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        /**
+         * Calls f(i) for every i in 0 to count - 1 using up to `workers` threads
+         * which take indices in chunks. The first exception thrown by any call
+         * is rethrown once all threads have finished.
+         */
+        template <class F>
+        void forEach(std::size_t count, F f, unsigned workers = threads(), std::size_t chunk = 1) {
+            workers = static_cast<unsigned>(std::min<std::size_t>(workers, (count + chunk - 1) / chunk));
+            if (workers <= 1) {
+                for (std::size_t i = 0; i < count; i++) {
+                    f(i);
+                }
+
+                return;
+            }
+
+            std::atomic<std::size_t> next(0);
+            std::exception_ptr error;
+            std::mutex mutex;
+
+            auto work = [&]() {
+                try {
+                    for (std::size_t begin; (begin = next.fetch_add(chunk)) < count;) {
+                        for (std::size_t i = begin; i < std::min(begin + chunk, count); i++) {
+                            f(i);
+                        }
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+
+                    next = count;
+                }
+            };
+
+            std::vector<std::thread> pool;
+            for (unsigned i = 1; i < workers; i++) {
+                pool.emplace_back(work);
+            }
+
+            work();
+            for (std::thread& thread : pool) {
+                thread.join();
+            }
+
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+    }
+
+}
+
+#endif
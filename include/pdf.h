@@ -0,0 +1,37 @@
+#ifndef PDF_H
+#define PDF_H
+
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include "qrcode.h"
+
+namespace Elliptic {
+
+    /**
+     * Minimal PDF 1.4 writer for vector pages using the standard Helvetica
+     * fonts (/F1 regular, /F2 bold), so no fonts or images are embedded.
+     * Coordinates are in points from the bottom left corner of the page.
+     */
+    class Pdf {
+    public:
+        static const double LETTER_WIDTH, LETTER_HEIGHT;
+
+        Pdf(double width = LETTER_WIDTH, double height = LETTER_HEIGHT) :
+            width_(width), height_(height) {}
+
+        void addPage(const std::string& content) { pages_.push_back(content); }
+        void save(const std::string& path) const;
+
+        static std::string text(double x, double y, double size, const std::string& text,
+                bool bold = false);
+        static std::string rectangle(double x, double y, double width, double height);
+        static std::string qrCode(const QRCode& code, double x, double y, double size);
+    private:
+        double width_, height_;
+        std::vector<std::string> pages_;
+    };
+
+}
+
+#endif
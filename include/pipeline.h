@@ -0,0 +1,217 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <algorithm>          // std::max
+#include <atomic>             // std::atomic
+#include <condition_variable> // std::condition_variable
+#include <cstddef>            // std::size_t
+#include <deque>              // std::deque
+#include <exception>          // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <functional>         // std::function
+#include <map>                // std::map
+#include <memory>             // std::unique_ptr
+#include <mutex>              // std::mutex, std::lock_guard, std::unique_lock
+#include <thread>             // std::thread
+#include <utility>            // std::move, std::pair
+#include <vector>             // std::vector
+
+#include "parallel.h"
+
+namespace Elliptic {
+
+    /**
+     * Bounded queue for any number of producers and consumers. push blocks
+     * while the queue is full and pop while it is empty; once closed, push
+     * fails and pop drains what is left.
+     */
+    template <class T>
+    class Queue {
+    public:
+        explicit Queue(std::size_t capacity) : capacity_(capacity), closed_(false) {}
+
+        bool push(T item) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notFull_.wait(lock, [this]() { return closed_ || items_.size() < capacity_; });
+            if (closed_) {
+                return false;
+            }
+
+            items_.push_back(std::move(item));
+            notEmpty_.notify_one();
+            return true;
+        }
+
+        bool pop(T& item) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notEmpty_.wait(lock, [this]() { return closed_ || !items_.empty(); });
+            if (items_.empty()) {
+                return false;
+            }
+
+            item = std::move(items_.front());
+            items_.pop_front();
+            notFull_.notify_one();
+            return true;
+        }
+
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            notFull_.notify_all();
+            notEmpty_.notify_all();
+        }
+    private:
+        std::size_t capacity_;
+        bool closed_;
+        std::deque<T> items_;
+        std::mutex mutex_;
+        std::condition_variable notFull_, notEmpty_;
+    };
+
+    /**
+     * Chain of stages over items in order: a source produces the items, every
+     * stage transforms them in place on its own worker threads, and a sink
+     * receives them in source order on the calling thread. At most `capacity`
+     * items are in flight between source and sink, so memory stays bounded
+     * however far the input runs ahead.
+     */
+    template <class T>
+    class Pipeline {
+    public:
+        typedef std::function<bool(T&)> Source; // Fills the next item, false at the end
+        typedef std::function<void(T&)> Stage;
+        typedef std::function<void(T&)> Sink;
+
+        explicit Pipeline(std::size_t capacity = 4*Parallel::threads() + 4)
+            : capacity_(capacity) {}
+
+        void addStage(Stage stage, unsigned workers = 1) {
+            stages_.push_back({ stage, std::max(1u, workers) });
+        }
+
+        /**
+         * Runs the source, stages and sink to completion. The first exception
+         * thrown by any of them stops the pipeline and is rethrown.
+         */
+        void run(Source source, Sink sink) {
+            typedef std::pair<std::size_t, T> Item;
+
+            std::vector<std::unique_ptr<Queue<Item>>> queues;
+            for (std::size_t s = 0; s <= stages_.size(); s++) {
+                queues.emplace_back(new Queue<Item>(capacity_));
+            }
+
+            std::mutex mutex;
+            std::condition_variable released;
+            std::size_t inFlight = 0;
+            std::exception_ptr error;
+
+            auto fail = [&]() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+
+                released.notify_all();
+                for (auto& queue : queues) {
+                    queue->close();
+                }
+            };
+
+            std::vector<std::thread> threads;
+            threads.emplace_back([&]() {
+                try {
+                    for (std::size_t sequence = 0;; sequence++) {
+                        {
+                            std::unique_lock<std::mutex> lock(mutex);
+                            released.wait(lock, [&]() { return error || inFlight < capacity_; });
+                            if (error) {
+                                break;
+                            }
+                            inFlight++;
+                        }
+
+                        Item item(sequence, T());
+                        if (!source(item.second) || !queues[0]->push(std::move(item))) {
+                            break;
+                        }
+                    }
+                } catch (...) {
+                    fail();
+                }
+
+                queues[0]->close();
+            });
+
+            std::vector<std::unique_ptr<std::atomic<unsigned>>> running;
+            for (const StageWorkers& stage : stages_) {
+                running.emplace_back(new std::atomic<unsigned>(stage.workers));
+            }
+
+            for (std::size_t s = 0; s < stages_.size(); s++) {
+                for (unsigned w = 0; w < stages_[s].workers; w++) {
+                    threads.emplace_back([&, s]() {
+                        try {
+                            Item item;
+                            while (queues[s]->pop(item)) {
+                                stages_[s].transform(item.second);
+                                if (!queues[s + 1]->push(std::move(item))) {
+                                    break;
+                                }
+                            }
+                        } catch (...) {
+                            fail();
+                        }
+
+                        // The last worker of a stage closes the next queue
+                        if (--*running[s] == 0) {
+                            queues[s + 1]->close();
+                        }
+                    });
+                }
+            }
+
+            // Items may finish out of order when a stage has several workers
+            std::map<std::size_t, T> pending;
+            std::size_t next = 0;
+            Item item;
+            try {
+                while (queues.back()->pop(item)) {
+                    pending.emplace(item.first, std::move(item.second));
+                    for (auto it = pending.begin(); it != pending.end() && it->first == next;
+                            it = pending.erase(it), next++) {
+                        sink(it->second);
+                        {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            inFlight--;
+                        }
+                        released.notify_one();
+                    }
+                }
+            } catch (...) {
+                fail();
+            }
+
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    private:
+        struct StageWorkers {
+            Stage transform;
+            unsigned workers;
+        };
+
+        std::size_t capacity_;
+        std::vector<StageWorkers> stages_;
+    };
+
+}
+
+#endif
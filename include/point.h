@@ -3,6 +3,7 @@
 
 #include <cstddef> // std::size_t
 #include <ostream> // std::ostream
+#include <utility> // std::move
 
 #include <gmpxx.h>
 
@@ -11,10 +12,10 @@ namespace Elliptic {
     class Point {
     public:
         Point() : x_(0), y_(0) {}
-        Point(mpz_class x, mpz_class y) : x_(x), y_(y) {}
+        Point(mpz_class x, mpz_class y) : x_(std::move(x)), y_(std::move(y)) {}
 
-        mpz_class getX() const { return x_; }
-        mpz_class getY() const { return y_; }
+        const mpz_class& getX() const { return x_; }
+        const mpz_class& getY() const { return y_; }
 
         bool isZero() const { return sgn(x_) == 0 && sgn(y_) == 0; }
         bool operator==(const Point &p) const { return cmp(x_, p.x_) == 0 && cmp(y_, p.y_) == 0; }
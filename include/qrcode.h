@@ -0,0 +1,43 @@
+#ifndef QRCODE_H
+#define QRCODE_H
+
+#include <cstdint> // std::uint8_t
+#include <string>  // std::string
+#include <vector>  // std::vector
+
+namespace Elliptic {
+
+    /**
+     * QR code (ISO/IEC 18004) for short text in byte mode with error correction
+     * level M, using the smallest of versions 1 to 10 (up to 213 bytes) that fits.
+     */
+    class QRCode {
+    public:
+        QRCode(const std::string& text);
+
+        int getSize() const { return size_; }
+        bool getModule(int x, int y) const { return modules_[y*size_ + x]; }
+    private:
+        static const int MAX_VERSION;
+        static const int ECC_CODEWORDS[], BLOCKS[];
+
+        int version_, size_;
+        std::vector<bool> modules_, function_;
+
+        void setFunction(int x, int y, bool dark);
+        void drawFunctionPatterns();
+        void drawFormatBits(int mask);
+        void drawCodewords(const std::vector<std::uint8_t>& codewords);
+        void applyMask(int mask);
+        long penalty() const;
+
+        std::vector<int> alignmentPositions() const;
+        std::vector<std::uint8_t> addErrorCorrection(const std::vector<std::uint8_t>& data) const;
+
+        static int rawCodewords(int version);
+        static std::uint8_t multiply(std::uint8_t x, std::uint8_t y);
+    };
+
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <array>   // std::array
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint8_t, std::uint32_t, std::uint64_t
+#include <vector>  // std::vector
+
+#include <gmpxx.h>
+
+namespace Elliptic {
+
+    /**
+     * Cryptographically secure random numbers from a per-thread ChaCha20 DRBG.
+     * Each thread seeds its generator from the operating system (getrandom) and
+     * refills a large keystream buffer at a time, re-keying from its own output
+     * after every refill (fast key erasure) and mixing in fresh OS entropy
+     * periodically and after a fork.
+     */
+    class Random {
+    public:
+        typedef std::array<std::uint8_t, 32> Scalar; // Big-endian
+
+        static void bytes(std::uint8_t* output, std::size_t length);
+
+        static Scalar scalar(const mpz_class& n);
+        static std::vector<Scalar> scalars(const mpz_class& n, std::size_t count);
+
+        static void chacha20(const std::uint32_t key[8], std::uint32_t counter,
+                const std::uint32_t nonce[3], std::uint8_t output[64]);
+    };
+
+    /**
+     * Fast per-thread non-cryptographic generator (xoshiro256**) seeded once
+     * from the operating system, for randomized algorithms only. It must NOT be
+     * used for private keys.
+     */
+    class FastRandom {
+    public:
+        static FastRandom& local();
+
+        std::uint64_t next();
+        mpz_class uniform(const mpz_class& n);
+    private:
+        FastRandom();
+
+        std::uint64_t state_[4];
+    };
+
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef RECOVERY_H
+#define RECOVERY_H
+
+#include <cstddef>       // std::size_t
+#include <cstdint>       // std::uint64_t
+#include <functional>    // std::function
+#include <string>        // std::string
+#include <unordered_set> // std::unordered_set
+#include <vector>        // std::vector
+
+#include "basetable.h"
+#include "bitcoin.h"
+#include "parallel.h"
+
+namespace Elliptic {
+
+    /**
+     * Recovers WIF or dice private keys with unreadable characters, written as
+     * WILDCARD. Candidates are enumerated in blocks across threads. WIF
+     * candidates are first filtered on their Base58Check checksum, which
+     * rejects all but about 1 in 2^32 without any point arithmetic; dice keys
+     * have no checksum, so their public keys are walked with one batched point
+     * addition per candidate and matched against the targets.
+     */
+    class Recovery {
+    public:
+        struct Match {
+            std::string privateHex;
+            bool compressed;
+        };
+
+        typedef std::function<void(std::uint64_t done, std::uint64_t total)> Progress;
+
+        static const char WILDCARD;
+
+        Recovery(const std::string& pattern);
+
+        void addTarget(const std::string& target);
+        std::uint64_t getCandidates() const { return candidates_; }
+
+        std::vector<Match> search(const std::string& checkpoint = "",
+                const Progress& progress = Progress(), unsigned workers = Parallel::threads()) const;
+    private:
+        static const std::uint64_t BLOCK;
+        static const std::size_t LANES;
+        static const int CHECKPOINT_SECONDS;
+
+        Secp256k1 curve_;
+        Bitcoin bitcoin_;
+        BaseTable table_;
+
+        std::string pattern_;
+        bool dice_;
+        unsigned radix_;
+        std::size_t bytes_;
+        std::uint64_t candidates_;
+        mpz_class base_;                // Pattern value with every wildcard 0
+        std::vector<mpz_class> weights_; // radix^position, least significant first
+        std::vector<mpz_class> deltas_;  // Value change when wildcard j is incremented
+        std::vector<Point> deltaPoints_;
+        std::unordered_set<std::string> targets_; // hash160
+
+        void searchBlock(std::uint64_t block, std::vector<Match>& matches) const;
+        void searchWIF(std::uint64_t first, std::uint64_t count, std::vector<Match>& matches) const;
+        void searchDice(std::uint64_t first, std::uint64_t count, std::vector<Match>& matches) const;
+
+        mpz_class value(std::uint64_t candidate) const;
+        std::size_t carry(std::vector<unsigned>& digits) const;
+        bool isTarget(const Point& p, bool compressed) const;
+
+        void loadCheckpoint(const std::string& path, std::uint64_t& done,
+                std::vector<Match>& matches) const;
+        void saveCheckpoint(const std::string& path, std::uint64_t done,
+                const std::vector<Match>& matches) const;
+    };
+
+}
+
+#endif
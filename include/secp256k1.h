@@ -13,8 +13,6 @@ namespace Elliptic {
     private:
         static const int A, B;
         static const std::string PRIME, ORDER;
-
-        static mpz_class convertHex(const std::string& hexString);
     };
 
 }
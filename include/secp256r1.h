@@ -0,0 +1,23 @@
+#ifndef SECP256R1_H
+#define SECP256R1_H
+
+#include "curve.h"
+
+namespace Elliptic {
+
+    /**
+     * NIST P-256.
+     */
+    class Secp256r1 : public Curve {
+    public:
+        Secp256r1() : Curve(convertHex(A), convertHex(B), convertHex(PRIME)) {}
+
+        mpz_class getOrder() const { return convertHex(ORDER); };
+        Point getBasePoint() const { return Point(convertHex(GX), convertHex(GY)); }
+    private:
+        static const std::string A, B, PRIME, ORDER, GX, GY;
+    };
+
+}
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <atomic>  // std::atomic
+#include <chrono>  // std::chrono::steady_clock, std::chrono::microseconds
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint8_t, std::uint32_t, std::uint64_t
+#include <mutex>   // std::mutex
+#include <string>  // std::string
+#include <vector>  // std::vector
+
+#include "basetable.h"
+#include "bitcoin.h"
+#include "parallel.h"
+
+namespace Elliptic {
+
+    /**
+     * Key derivation daemon on a Unix domain socket. Requests are fixed
+     * REQUEST_SIZE frames
+     *
+     *     id (4 bytes, little-endian) | op (1) | flags (1) | private key (32, big-endian)
+     *
+     * answered, possibly out of order, by
+     *
+     *     id (4) | status (1) | length (1) | payload (length bytes)
+     *
+     * where the payload is the public key (33 or 65 bytes) or the address (Base58
+     * text). A single epoll loop reads all connections and coalesces their
+     * requests into batches of up to maxBatch, flushed once the oldest request
+     * has waited `deadline`. Worker threads multiply each batch through one
+     * shared BaseTable, so a batch costs one inversion per window instead of a
+     * scalar multiplication per request.
+     */
+    class Server {
+    public:
+        enum Op : std::uint8_t { PUBLIC_KEY, ADDRESS, STATS };
+        enum Status : std::uint8_t { OK, INVALID_KEY, BAD_REQUEST };
+
+        static const std::size_t REQUEST_SIZE = 38;
+        static const std::size_t RESPONSE_HEADER = 6;
+        static const std::uint8_t COMPRESSED = 1; // Request flag
+
+        struct Options {
+            std::string path;
+            std::size_t maxBatch = 256;
+            std::chrono::microseconds deadline = std::chrono::microseconds(200);
+            unsigned workers = Parallel::threads();
+            std::size_t maxOutstanding = 4096; // Unanswered requests per connection before reading pauses
+        };
+
+        /**
+         * Counters since start, over PUBLIC_KEY and ADDRESS requests only.
+         * Latency runs from reading a request to queueing its response, over
+         * the last LATENCIES requests. STATS answers with the six fields as
+         * little-endian 64-bit integers in this order.
+         */
+        struct Stats {
+            std::uint64_t requests, batches, errors;
+            std::uint64_t p50, p99;      // Nanoseconds
+            std::uint64_t microseconds; // Uptime
+        };
+
+        static const std::size_t LATENCIES;
+
+        explicit Server(const Options& options);
+        ~Server();
+
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+
+        void run();
+        void stop();
+        Stats stats() const;
+    private:
+        struct Request;
+        struct Response;
+
+        Options options_;
+        Secp256k1 curve_;
+        Bitcoin bitcoin_;
+        BaseTable table_;
+
+        int listener_; // Listening from construction, so clients may connect before run()
+        int wake_;     // eventfd, signalled by stop() and finished batches
+        std::atomic<bool> stopping_;
+        std::chrono::steady_clock::time_point start_;
+
+        std::atomic<std::uint64_t> requests_, batches_, errors_;
+        mutable std::mutex latencyMutex_;
+        std::vector<std::uint64_t> latencies_;
+        std::size_t latencyCount_;
+
+        std::vector<Response> derive(const std::vector<Request>& batch) const;
+        void record(std::uint64_t nanoseconds);
+    };
+
+    /**
+     * Blocking client for Server, which can keep several requests in flight
+     * on one connection.
+     */
+    class ServerClient {
+    public:
+        struct Response {
+            std::uint32_t id;
+            Server::Status status;
+            std::string payload;
+        };
+
+        /**
+         * Result of `load`, latencies as seen by the clients.
+         */
+        struct Report {
+            std::uint64_t requests, errors;
+            double seconds;
+            std::uint64_t p50, p99; // Nanoseconds
+        };
+
+        explicit ServerClient(const std::string& path);
+        ~ServerClient();
+
+        ServerClient(const ServerClient&) = delete;
+        ServerClient& operator=(const ServerClient&) = delete;
+
+        void send(std::uint32_t id, Server::Op op, const std::string& privateHex = "", bool compressed = true);
+        void finish();
+        Response receive();
+        Server::Stats stats();
+
+        static Report load(const std::string& path, unsigned connections, std::uint64_t requests,
+                std::size_t depth, Server::Op op = Server::ADDRESS);
+    private:
+        int socket_;
+
+        void read(std::uint8_t* buffer, std::size_t length);
+    };
+
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <vector>  // std::vector
+
+#include <gmpxx.h>
+
+namespace Elliptic {
+
+    /**
+     * Montgomery arithmetic modulo an odd prime below 2^256 on whole arrays of
+     * independent elements, vectorized with AVX-512 IFMA (8 elements, radix
+     * 2^52) or AVX2 (4 elements, radix 2^26) when the CPU supports them and a
+     * portable scalar loop otherwise. Elements are stored structure-of-arrays,
+     * limb j of element e at data[j*stride + e], in Montgomery form aR mod p
+     * with R = 2^260 in either radix.
+     */
+    class VectorField {
+    public:
+        enum Level { SCALAR, AVX2, AVX512_IFMA };
+
+        /**
+         * count elements padded to a multiple of 8 with limb j of element e at
+         * data_[j*stride_ + e].
+         */
+        class Vector {
+        public:
+            Vector() : count_(0), stride_(0) {}
+
+            std::size_t size() const { return count_; }
+        private:
+            friend class VectorField;
+
+            std::size_t count_, stride_;
+            std::vector<std::uint64_t> data_;
+        };
+
+        static const int WORDS = 4; // 64-bit words of an element outside the field
+
+        static Level best();
+
+        explicit VectorField(const mpz_class& prime, Level level = best());
+
+        Level getLevel() const { return level_; }
+        std::size_t getLanes() const { return lanes_; }
+
+        Vector vector(std::size_t count) const;
+
+        /**
+         * Conversions to and from r.size() (a.size()) integers below the prime
+         * stored as WORDS little-endian 64-bit words each.
+         */
+        void fromWords(Vector& r, const std::uint64_t* words) const;
+        void toWords(std::uint64_t* words, const Vector& a) const;
+
+        // r may alias a or b
+
+        void add(Vector& r, const Vector& a, const Vector& b) const;
+        void subtract(Vector& r, const Vector& a, const Vector& b) const;
+        void multiply(Vector& r, const Vector& a, const Vector& b) const;
+        void square(Vector& r, const Vector& a) const { multiply(r, a, a); }
+        void inverse(Vector& r, const Vector& a) const;
+
+        struct Kernel; // Per-level limb loops, see simd.cpp
+    private:
+        static const std::size_t ROW = 8; // Elements per row, the widest lane count
+
+        Level level_;
+        std::size_t lanes_, limbs_;
+        unsigned radix_;
+        mpz_class prime_;
+        std::vector<std::uint64_t> p_; // Prime in radix 2^radix
+        std::uint64_t inv_;            // -p^-1 mod 2^radix
+        Vector one_, unit_, r2_;       // R mod p, 1 and R^2 mod p in every lane of a row
+        const Kernel* kernel_;
+
+        void multiply(std::uint64_t* r, const std::uint64_t* a, const std::uint64_t* b,
+                std::size_t stride, std::size_t bStride, bool bAdvance, std::size_t count) const;
+        void shape(Vector& r, const Vector& a, const Vector& b) const;
+        void pack(Vector& r, std::size_t e, const mpz_class& op) const;
+        mpz_class unpack(const Vector& a, std::size_t e) const;
+    };
+
+}
+
+#endif
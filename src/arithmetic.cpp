@@ -0,0 +1,598 @@
+#include "arithmetic.h"
+
+#include <algorithm> // std::equal, std::fill
+
+#include "field.h"
+#include "instrument.h"
+#include "msm.h"
+#include "simd.h"
+
+const std::size_t Elliptic::Arithmetic::MAX_LIMBS = 9; // P-521
+
+namespace {
+
+    using Elliptic::Field;
+    using Elliptic::Point;
+    using Elliptic::VectorField;
+
+    // Smallest batch worth converting to the SIMD layout
+    const std::size_t VECTOR_BATCH = 16;
+
+    /**
+     * Curve arithmetic over Field<N>. Scalar multiplication runs in Jacobian
+     * coordinates, (X, Y, Z) = (X/Z^2, Y/Z^3), so the only inversion is the
+     * final conversion back to affine coordinates.
+     */
+    template <std::size_t N>
+    class FieldArithmetic : public Elliptic::Arithmetic {
+    public:
+        typedef typename Field<N>::Element Element;
+
+        FieldArithmetic(const mpz_class& a, const mpz_class& b, const mpz_class& prime)
+                : field_(prime), a_(field_.fromMpz(a)), b_(field_.fromMpz(b)),
+                aZero_(Field<N>::isZero(a_)) {
+            if (N <= VectorField::WORDS && VectorField::best() != VectorField::SCALAR) {
+                vector_.reset(new VectorField(prime));
+            }
+        }
+
+        bool hasPoint(const Point& p) const;
+        Point add(const Point& p, const Point& q) const;
+        Point twice(const Point& p) const;
+        Point multiply(const Point& p, const mpz_class& n) const;
+        Point multiply(const std::vector<Point>& points, const std::vector<mpz_class>& scalars,
+                unsigned workers) const;
+        void add(std::vector<Point>& points, const Point* q, std::size_t stride) const;
+    private:
+        struct Jacobian {
+            Element X, Y, Z;
+        };
+
+        struct Affine {
+            Element x, y;
+        };
+
+        /**
+         * Jacobian accumulators over affine inputs for Msm.
+         */
+        class Group {
+        public:
+            typedef Jacobian Element;
+            typedef Affine Base;
+
+            Group(const FieldArithmetic& arithmetic) : arithmetic_(arithmetic) {}
+
+            Jacobian identity() const {
+                return { arithmetic_.field_.one(), arithmetic_.field_.one(), arithmetic_.field_.zero() };
+            }
+
+            Affine fromPoint(const Point& p) const {
+                return { arithmetic_.field_.fromMpz(p.getX()), arithmetic_.field_.fromMpz(p.getY()) };
+            }
+
+            Jacobian fromBase(const Affine& p) const { return { p.x, p.y, arithmetic_.field_.one() }; }
+            Point toPoint(const Jacobian& p) const { return arithmetic_.toAffine(p); }
+            void add(Jacobian& p, const Jacobian& q) const { arithmetic_.addJacobian(p, q); }
+            void add(Jacobian& p, const Affine& q) const { arithmetic_.addAffine(p, q.x, q.y); }
+            void twice(Jacobian& p) const { arithmetic_.twice(p); }
+        private:
+            const FieldArithmetic& arithmetic_;
+        };
+
+        Field<N> field_;
+        Element a_, b_;
+        bool aZero_;
+        std::unique_ptr<VectorField> vector_; // Null without SIMD or for primes above 2^256
+
+        Point toPoint(const Element& x, const Element& y) const;
+        Point toAffine(const Jacobian& p) const;
+        void twice(Jacobian& p) const;
+        void addAffine(Jacobian& p, const Element& x, const Element& y) const;
+        void addJacobian(Jacobian& p, const Jacobian& q) const;
+        void addVector(std::vector<Point>& points, const Point* q, std::size_t stride) const;
+        void toWords(std::uint64_t* words, const mpz_class& op) const;
+    };
+
+    /**
+     * Checks y^2 = x^3 + ax + b (mod p).
+     */
+    template <std::size_t N>
+    bool FieldArithmetic<N>::hasPoint(const Point& p) const {
+        Element x = field_.fromMpz(p.getX()), y = field_.fromMpz(p.getY()), left, right, t;
+
+        field_.square(left, y);
+
+        field_.square(right, x);
+        field_.multiply(right, right, x);
+        field_.multiply(t, a_, x);
+        field_.add(right, right, t);
+        field_.add(right, right, b_);
+
+        return left == right;
+    }
+
+    /**
+     * Affine addition with one field inversion.
+     */
+    template <std::size_t N>
+    Point FieldArithmetic<N>::add(const Point& p, const Point& q) const {
+        if (q.isZero()) {
+            return p;
+        }
+
+        if (p.isZero()) {
+            return q;
+        }
+
+        Element px = field_.fromMpz(p.getX()), py = field_.fromMpz(p.getY());
+        Element qx = field_.fromMpz(q.getX()), qy = field_.fromMpz(q.getY());
+        if (px == qx) {
+            return py == qy ? twice(p) : Point();
+        }
+
+        ELLIPTIC_COUNT(INVERSIONS);
+
+        // lambda = (py - qy) / (px - qx)
+        Element lambda, denom, x, y;
+        field_.subtract(denom, px, qx);
+        field_.inverse(denom, denom);
+        field_.subtract(lambda, py, qy);
+        field_.multiply(lambda, lambda, denom);
+
+        field_.square(x, lambda);
+        field_.subtract(x, x, px);
+        field_.subtract(x, x, qx);
+
+        field_.subtract(y, px, x);
+        field_.multiply(y, y, lambda);
+        field_.subtract(y, y, py);
+
+        return toPoint(x, y);
+    }
+
+    /**
+     * Affine doubling with one field inversion.
+     */
+    template <std::size_t N>
+    Point FieldArithmetic<N>::twice(const Point& p) const {
+        if (p.isZero()) {
+            return p;
+        }
+
+        Element px = field_.fromMpz(p.getX()), py = field_.fromMpz(p.getY());
+        if (Field<N>::isZero(py)) {
+            return Point();
+        }
+
+        ELLIPTIC_COUNT(INVERSIONS);
+
+        // lambda = (3x^2 + a) / 2y
+        Element lambda, denom, x, y;
+        field_.add(denom, py, py);
+        field_.inverse(denom, denom);
+        field_.square(x, px);
+        field_.add(lambda, x, x);
+        field_.add(lambda, lambda, x);
+        field_.add(lambda, lambda, a_);
+        field_.multiply(lambda, lambda, denom);
+
+        field_.square(x, lambda);
+        field_.subtract(x, x, px);
+        field_.subtract(x, x, px);
+
+        field_.subtract(y, px, x);
+        field_.multiply(y, y, lambda);
+        field_.subtract(y, y, py);
+
+        return toPoint(x, y);
+    }
+
+    /**
+     * Left-to-right double-and-add in Jacobian coordinates, adding the affine
+     * point p, for n > 0.
+     */
+    template <std::size_t N>
+    Point FieldArithmetic<N>::multiply(const Point& p, const mpz_class& n) const {
+        if (p.isZero()) {
+            return p;
+        }
+
+        Element x = field_.fromMpz(p.getX()), y = field_.fromMpz(p.getY());
+        Jacobian q = { x, y, field_.one() };
+        for (std::size_t i = mpz_sizeinbase(n.get_mpz_t(), 2) - 1; i-- > 0;) {
+            twice(q);
+            if (mpz_tstbit(n.get_mpz_t(), i)) {
+                addAffine(q, x, y);
+            }
+        }
+
+        return toAffine(q);
+    }
+
+    template <std::size_t N>
+    Point FieldArithmetic<N>::multiply(const std::vector<Point>& points,
+            const std::vector<mpz_class>& scalars, unsigned workers) const {
+        return Elliptic::Msm::multiply(Group(*this), points, scalars, workers);
+    }
+
+    /**
+     * Batched affine addition with Montgomery's trick, see Curve::add.
+     */
+    template <std::size_t N>
+    void FieldArithmetic<N>::add(std::vector<Point>& points, const Point* q, std::size_t stride) const {
+        if (vector_ && points.size() >= VECTOR_BATCH) {
+            addVector(points, q, stride);
+            return;
+        }
+
+        struct Pending {
+            std::size_t i;
+            Element px, py, qx, qy, denom, prefix;
+        };
+
+        std::vector<Pending> batch;
+        batch.reserve(points.size());
+
+        Element qx, qy, product = field_.one();
+        bool converted = false;
+        for (std::size_t i = 0; i < points.size(); i++) {
+            const Point& p = points[i];
+            const Point& r = q[i*stride];
+            if (p.isZero() || r.isZero()) {
+                points[i] = add(p, r);
+                continue;
+            }
+
+            if (!converted || stride != 0) {
+                qx = field_.fromMpz(r.getX());
+                qy = field_.fromMpz(r.getY());
+                converted = true;
+            }
+
+            Pending pending = { i, field_.fromMpz(p.getX()), field_.fromMpz(p.getY()), qx, qy };
+            if (pending.px == qx) {
+                points[i] = add(p, r);
+                continue;
+            }
+
+            field_.subtract(pending.denom, pending.px, qx);
+            pending.prefix = product;
+            field_.multiply(product, product, pending.denom);
+            batch.push_back(pending);
+        }
+
+        if (batch.empty()) {
+            return;
+        }
+
+        ELLIPTIC_COUNT(INVERSIONS);
+
+        Element inv, lambda, x, y;
+        field_.inverse(inv, product);
+        for (std::size_t t = batch.size(); t-- > 0;) {
+            const Pending& b = batch[t];
+            field_.multiply(lambda, inv, b.prefix);
+            field_.multiply(inv, inv, b.denom);
+
+            field_.subtract(y, b.py, b.qy);
+            field_.multiply(lambda, lambda, y);
+
+            field_.square(x, lambda);
+            field_.subtract(x, x, b.px);
+            field_.subtract(x, x, b.qx);
+
+            field_.subtract(y, b.px, x);
+            field_.multiply(y, y, lambda);
+            field_.subtract(y, y, b.py);
+
+            points[b.i] = toPoint(x, y);
+        }
+    }
+
+    /**
+     * The same batched addition across the lanes of VectorField, with the
+     * special cases taken one at a time as above.
+     */
+    template <std::size_t N>
+    void FieldArithmetic<N>::addVector(std::vector<Point>& points, const Point* q, std::size_t stride) const {
+        const std::size_t W = VectorField::WORDS;
+
+        std::vector<std::size_t> batch;
+        std::vector<std::uint64_t> px(W*points.size()), py(px.size()), qx(px.size()), qy(px.size());
+        for (std::size_t i = 0; i < points.size(); i++) {
+            const Point& p = points[i];
+            const Point& r = q[i*stride];
+            if (p.isZero() || r.isZero()) {
+                points[i] = add(p, r);
+                continue;
+            }
+
+            std::size_t t = W*batch.size();
+            toWords(&px[t], p.getX());
+            toWords(&qx[t], r.getX());
+            if (std::equal(&px[t], &px[t] + W, &qx[t])) {
+                points[i] = add(p, r);
+                continue;
+            }
+
+            toWords(&py[t], p.getY());
+            toWords(&qy[t], r.getY());
+            batch.push_back(i);
+        }
+
+        if (batch.empty()) {
+            return;
+        }
+
+        ELLIPTIC_COUNT(INVERSIONS);
+
+        VectorField::Vector x1 = vector_->vector(batch.size()), y1 = x1, x2 = x1, y2 = x1, lambda, x3;
+        vector_->fromWords(x1, px.data());
+        vector_->fromWords(y1, py.data());
+        vector_->fromWords(x2, qx.data());
+        vector_->fromWords(y2, qy.data());
+
+        // lambda = (y1 - y2) / (x1 - x2)
+        vector_->subtract(x3, x1, x2);
+        vector_->inverse(x3, x3);
+        vector_->subtract(lambda, y1, y2);
+        vector_->multiply(lambda, lambda, x3);
+
+        vector_->square(x3, lambda);
+        vector_->subtract(x3, x3, x1);
+        vector_->subtract(x3, x3, x2);
+
+        vector_->subtract(y2, x1, x3);
+        vector_->multiply(y2, y2, lambda);
+        vector_->subtract(y2, y2, y1);
+
+        vector_->toWords(px.data(), x3);
+        vector_->toWords(py.data(), y2);
+        for (std::size_t t = 0; t < batch.size(); t++) {
+            mpz_class x, y;
+            mpz_import(x.get_mpz_t(), W, -1, sizeof(std::uint64_t), 0, 0, &px[W*t]);
+            mpz_import(y.get_mpz_t(), W, -1, sizeof(std::uint64_t), 0, 0, &py[W*t]);
+            points[batch[t]] = Point(x, y);
+        }
+    }
+
+    /**
+     * Exports an integer reduced mod p as VectorField::WORDS words.
+     */
+    template <std::size_t N>
+    void FieldArithmetic<N>::toWords(std::uint64_t* words, const mpz_class& op) const {
+        std::fill(words, words + VectorField::WORDS, 0);
+        if (sgn(op) < 0 || cmp(op, field_.getPrime()) >= 0) {
+            mpz_class reduced;
+            mpz_mod(reduced.get_mpz_t(), op.get_mpz_t(), field_.getPrime().get_mpz_t());
+            mpz_export(words, nullptr, -1, sizeof(std::uint64_t), 0, 0, reduced.get_mpz_t());
+        } else {
+            mpz_export(words, nullptr, -1, sizeof(std::uint64_t), 0, 0, op.get_mpz_t());
+        }
+    }
+
+    template <std::size_t N>
+    Point FieldArithmetic<N>::toPoint(const Element& x, const Element& y) const {
+        return Point(field_.toMpz(x), field_.toMpz(y));
+    }
+
+    template <std::size_t N>
+    Point FieldArithmetic<N>::toAffine(const Jacobian& p) const {
+        if (Field<N>::isZero(p.Z)) {
+            return Point();
+        }
+
+        ELLIPTIC_COUNT(INVERSIONS);
+
+        Element zi, zi2, x, y;
+        field_.inverse(zi, p.Z);
+        field_.square(zi2, zi);
+        field_.multiply(x, p.X, zi2);
+        field_.multiply(y, p.Y, zi2);
+        field_.multiply(y, y, zi);
+
+        return toPoint(x, y);
+    }
+
+    /**
+     * Jacobian doubling (dbl-2007-bl). Points with Z = 0 or Y = 0 double to
+     * Z = 0, the identity.
+     */
+    template <std::size_t N>
+    void FieldArithmetic<N>::twice(Jacobian& p) const {
+        Element XX, YY, YYYY, ZZ, S, M, T;
+        field_.square(XX, p.X);
+        field_.square(YY, p.Y);
+        field_.square(YYYY, YY);
+        field_.square(ZZ, p.Z);
+
+        // S = 2((X + YY)^2 - XX - YYYY)
+        field_.add(S, p.X, YY);
+        field_.square(S, S);
+        field_.subtract(S, S, XX);
+        field_.subtract(S, S, YYYY);
+        field_.add(S, S, S);
+
+        // M = 3XX + aZZ^2
+        field_.add(M, XX, XX);
+        field_.add(M, M, XX);
+        if (!aZero_) {
+            field_.square(T, ZZ);
+            field_.multiply(T, T, a_);
+            field_.add(M, M, T);
+        }
+
+        // Z3 = (Y + Z)^2 - YY - ZZ
+        field_.add(p.Z, p.Y, p.Z);
+        field_.square(p.Z, p.Z);
+        field_.subtract(p.Z, p.Z, YY);
+        field_.subtract(p.Z, p.Z, ZZ);
+
+        // X3 = M^2 - 2S
+        field_.square(T, M);
+        field_.subtract(T, T, S);
+        field_.subtract(T, T, S);
+        p.X = T;
+
+        // Y3 = M(S - X3) - 8YYYY
+        field_.subtract(S, S, T);
+        field_.multiply(p.Y, M, S);
+        field_.add(YYYY, YYYY, YYYY);
+        field_.add(YYYY, YYYY, YYYY);
+        field_.add(YYYY, YYYY, YYYY);
+        field_.subtract(p.Y, p.Y, YYYY);
+    }
+
+    /**
+     * Mixed Jacobian-affine addition (madd-2007-bl).
+     */
+    template <std::size_t N>
+    void FieldArithmetic<N>::addAffine(Jacobian& p, const Element& x, const Element& y) const {
+        if (Field<N>::isZero(p.Z)) {
+            p = { x, y, field_.one() };
+            return;
+        }
+
+        Element Z1Z1, U2, S2, H, HH, I, J, r, V;
+        field_.square(Z1Z1, p.Z);
+        field_.multiply(U2, x, Z1Z1);
+        field_.multiply(S2, y, p.Z);
+        field_.multiply(S2, S2, Z1Z1);
+
+        field_.subtract(H, U2, p.X);
+        field_.subtract(r, S2, p.Y);
+        if (Field<N>::isZero(H)) {
+            if (Field<N>::isZero(r)) {
+                twice(p);
+            } else {
+                p.Z = field_.zero();
+            }
+
+            return;
+        }
+
+        field_.square(HH, H);
+        field_.add(I, HH, HH);
+        field_.add(I, I, I);
+        field_.multiply(J, H, I);
+        field_.add(r, r, r);
+        field_.multiply(V, p.X, I);
+
+        // X3 = r^2 - J - 2V
+        Element X3;
+        field_.square(X3, r);
+        field_.subtract(X3, X3, J);
+        field_.subtract(X3, X3, V);
+        field_.subtract(X3, X3, V);
+
+        // Y3 = r(V - X3) - 2 Y1 J
+        field_.multiply(J, J, p.Y);
+        field_.add(J, J, J);
+        field_.subtract(V, V, X3);
+        field_.multiply(p.Y, r, V);
+        field_.subtract(p.Y, p.Y, J);
+
+        // Z3 = (Z1 + H)^2 - Z1Z1 - HH
+        field_.add(p.Z, p.Z, H);
+        field_.square(p.Z, p.Z);
+        field_.subtract(p.Z, p.Z, Z1Z1);
+        field_.subtract(p.Z, p.Z, HH);
+
+        p.X = X3;
+    }
+
+    /**
+     * Jacobian addition (add-2007-bl).
+     */
+    template <std::size_t N>
+    void FieldArithmetic<N>::addJacobian(Jacobian& p, const Jacobian& q) const {
+        if (Field<N>::isZero(q.Z)) {
+            return;
+        }
+
+        if (Field<N>::isZero(p.Z)) {
+            p = q;
+            return;
+        }
+
+        Element Z1Z1, Z2Z2, U1, U2, S1, S2, H, I, J, r, V;
+        field_.square(Z1Z1, p.Z);
+        field_.square(Z2Z2, q.Z);
+        field_.multiply(U1, p.X, Z2Z2);
+        field_.multiply(U2, q.X, Z1Z1);
+        field_.multiply(S1, p.Y, q.Z);
+        field_.multiply(S1, S1, Z2Z2);
+        field_.multiply(S2, q.Y, p.Z);
+        field_.multiply(S2, S2, Z1Z1);
+
+        field_.subtract(H, U2, U1);
+        field_.subtract(r, S2, S1);
+        if (Field<N>::isZero(H)) {
+            if (Field<N>::isZero(r)) {
+                twice(p);
+            } else {
+                p.Z = field_.zero();
+            }
+
+            return;
+        }
+
+        field_.add(I, H, H);
+        field_.square(I, I);
+        field_.multiply(J, H, I);
+        field_.add(r, r, r);
+        field_.multiply(V, U1, I);
+
+        // X3 = r^2 - J - 2V
+        field_.square(p.X, r);
+        field_.subtract(p.X, p.X, J);
+        field_.subtract(p.X, p.X, V);
+        field_.subtract(p.X, p.X, V);
+
+        // Y3 = r(V - X3) - 2 S1 J
+        field_.subtract(V, V, p.X);
+        field_.multiply(p.Y, r, V);
+        field_.multiply(S1, S1, J);
+        field_.add(S1, S1, S1);
+        field_.subtract(p.Y, p.Y, S1);
+
+        // Z3 = ((Z1 + Z2)^2 - Z1Z1 - Z2Z2) H
+        field_.add(p.Z, p.Z, q.Z);
+        field_.square(p.Z, p.Z);
+        field_.subtract(p.Z, p.Z, Z1Z1);
+        field_.subtract(p.Z, p.Z, Z2Z2);
+        field_.multiply(p.Z, p.Z, H);
+    }
+
+    template <std::size_t N>
+    std::unique_ptr<Elliptic::Arithmetic> create(const mpz_class& a, const mpz_class& b,
+            const mpz_class& prime) {
+        return std::unique_ptr<Elliptic::Arithmetic>(new FieldArithmetic<N>(a, b, prime));
+    }
+
+}
+
+/**
+ * Picks the fixed-width field backend with the fewest 64-bit limbs holding the
+ * prime, up to MAX_LIMBS. Returns null for primes that need the generic
+ * mpz_class arithmetic (even or wider than MAX_LIMBS limbs).
+ */
+std::unique_ptr<Elliptic::Arithmetic> Elliptic::Arithmetic::create(const mpz_class& a,
+        const mpz_class& b, const mpz_class& prime) {
+    if (cmp(prime, 2) <= 0 || mpz_even_p(prime.get_mpz_t())) {
+        return nullptr;
+    }
+
+    switch ((mpz_sizeinbase(prime.get_mpz_t(), 2) + 63)/64) {
+        case 1: return ::create<1>(a, b, prime);
+        case 2: return ::create<2>(a, b, prime);
+        case 3: return ::create<3>(a, b, prime);
+        case 4: return ::create<4>(a, b, prime);
+        case 5: return ::create<5>(a, b, prime);
+        case 6: return ::create<6>(a, b, prime);
+        case 7: return ::create<7>(a, b, prime);
+        case 8: return ::create<8>(a, b, prime);
+        case 9: return ::create<9>(a, b, prime);
+        default: return nullptr;
+    }
+}
@@ -1,83 +1,434 @@
 #include "babygiant.h"
 
-#include <cstdlib>       // std::rand, std::srand
-#include <ctime>         // std::time
+#include <algorithm>     // std::sort
 #include <stdexcept>     // std::invalid_argument
 
+#include "instrument.h"
+#include "random.h"
+
 const long Elliptic::BabyGiant::MEMORY_LIMIT = 50000000;
+const std::size_t Elliptic::BabyGiant::TABLE_CACHE = 16;
+const unsigned long Elliptic::BabyGiant::TRIAL_DIVISION = 1 << 16;
+const unsigned long Elliptic::BabyGiant::RHO_ITERATIONS = 1 << 22;
 
 /**
  * Computes a discrete logarithm on the given elliptic curve i.e., finds k such
- * that kG = P. The basic algorithm has space and time complexity of O(\sqrt{n})
- * where n is the order of the curve. Completeness is not guaranteed for \sqrt{n}
- * greater than the memory limit.
+ * that kG = P. The basic algorithm has space and time complexity of O(\sqrt{q})
+ * where q is the largest prime factor of the order of the curve. Completeness is
+ * not guaranteed for \sqrt{q} greater than the memory limit. Baby-step tables
+ * are kept for later queries with the same base point.
  */
 mpz_class Elliptic::BabyGiant::discreteLogarithm(const Point& G, const Point& P) {
-    if (!curve_->hasPoint(G) || !curve_->hasPoint(P)) {
+    mpz_class k = discreteLogarithm(G, std::vector<Point>(1, P))[0];
+    if (sgn(k) < 0) {
+        throw std::invalid_argument("Could not find k such that kG = P, increase memory limit");
+    }
+
+    return k;
+}
+
+/**
+ * Computes k_i such that k_i G = P_i for every target, see the callback
+ * overload below. Targets that could not be found are left at k_i = -1, so
+ * the logarithms that were found are never lost.
+ */
+std::vector<mpz_class> Elliptic::BabyGiant::discreteLogarithm(const Point& G,
+        const std::vector<Point>& P) {
+    std::vector<mpz_class> k(P.size(), -1);
+    discreteLogarithm(G, P, [&k](std::size_t i, const mpz_class& ki) { k[i] = ki; });
+
+    return k;
+}
+
+/**
+ * Computes k_i such that k_i G = P_i for many targets. When the curve order n
+ * is composite the problem is split with Pohlig-Hellman into subproblems of
+ * prime order, otherwise baby-step giant-step runs on the whole group.
+ * `resolved` is called with the index of each target as soon as it is found;
+ * the indices of the targets that could not be found, for lack of memory or
+ * because they are not multiples of G, are returned.
+ */
+std::vector<std::size_t> Elliptic::BabyGiant::discreteLogarithm(const Point& G,
+        const std::vector<Point>& P,
+        const std::function<void(std::size_t, const mpz_class&)>& resolved) {
+    if (!curve_->hasPoint(G)) {
         throw std::invalid_argument("Base point or public key is not on the curve");
     }
 
-    mpz_class n = curve_->getOrder();
-    mpz_class m = sqrt(n) + 1; // m = ceil(sqrt(n))
+    for (const Point& p : P) {
+        if (!curve_->hasPoint(p)) {
+            throw std::invalid_argument("Base point or public key is not on the curve");
+        }
+    }
+
+    const std::vector<Factor>& factors = getFactors();
+    if (factors.size() == 1 && factors[0].second == 1) {
+        return solve(G, getOrder(), P, resolved);
+    }
+
+    return pohligHellman(G, P, resolved);
+}
+
+/**
+ * Memory-maps a baby-step table written by `saveTable`. The table is used for
+ * every following query with a matching base point.
+ */
+void Elliptic::BabyGiant::loadTable(const std::string& path) {
+    std::unique_ptr<BabyStepTable> table(new BabyStepTable(path));
+    if (!table->matches(*curve_)) {
+        throw std::invalid_argument("Baby-step table " + path + " was built for another curve");
+    }
+
+    cacheTable(std::move(table));
+}
+
+/**
+ * Builds (or reuses) the baby-step table for G over the whole group and writes
+ * it to disk. Such a table is only used when the curve order is prime.
+ */
+void Elliptic::BabyGiant::saveTable(const Point& G, const std::string& path) {
+    if (!curve_->hasPoint(G)) {
+        throw std::invalid_argument("Base point is not on the curve");
+    }
+
+    getTable(G, getStepSize(getOrder())).save(path);
+}
+
+/**
+ * Baby-step giant-step for k_i in 0 to n - 1 with k_i G = P_i, where n is a
+ * multiple of the order of G. All of the targets share one baby-step table and
+ * take their giant steps together, so each step costs one field inversion
+ * regardless of the number of targets. Returns the indices of the targets
+ * that were not found.
+ */
+std::vector<std::size_t> Elliptic::BabyGiant::solve(const Point& G, const mpz_class& n,
+        const std::vector<Point>& P,
+        const std::function<void(std::size_t, const mpz_class&)>& resolved) {
+    // Q_t = P_t - rmG, then Q_t = P_t - imG after each giant step
+    std::vector<Point> Q;
+    std::vector<std::size_t> index;
+    for (std::size_t t = 0; t < P.size(); t++) {
+        if (P[t].isZero()) {
+            resolved(t, 0);
+        } else {
+            Q.push_back(P[t]);
+            index.push_back(t);
+        }
+    }
+
+    if (Q.empty()) {
+        return index;
+    }
 
-    std::unordered_map<Point, long, PointHasher> table;
-    populateTable(table, G, m);
+    mpz_class m = getStepSize(n);
+    const BabyStepTable& table = getTable(G, m);
 
+    ELLIPTIC_TIMER(GIANT_STEPS);
     mpz_class r = getRandom(m);
     Point mG = curve_->multiply(G, m);
-    Point imG = curve_->multiply(mG, r);
-    for (mpz_class i = r; i < m + r; i++) {
-        // Q = P - imG
-        Point Q = curve_->add(P, curve_->negatePoint(imG));
 
-        if (table.find(Q) != table.end()) {
-            long j = table[Q];
-            mpz_class k = i*m + j;
-            mpz_mod(k.get_mpz_t(), k.get_mpz_t(), n.get_mpz_t());
-            return k;
+    curve_->add(Q, curve_->negatePoint(curve_->multiply(mG, r)));
+    Point step = curve_->negatePoint(mG);
+
+    for (mpz_class i = r; i < m + r && !Q.empty(); i++) {
+        for (std::size_t t = 0; t < Q.size();) {
+            auto range = table.find(Q[t]);
+
+            bool found = false;
+            for (auto entry = range.first; entry != range.second && !found; entry++) {
+                mpz_class k = i*m + entry->j;
+                mpz_mod(k.get_mpz_t(), k.get_mpz_t(), n.get_mpz_t());
+
+                // Fingerprints can collide, confirm kG = P
+                if (sgn(k) > 0 && curve_->multiply(G, k) == P[index[t]]) {
+                    resolved(index[t], k);
+                    found = true;
+                }
+            }
+
+            if (found) {
+                Q[t] = Q.back();
+                Q.pop_back();
+                index[t] = index.back();
+                index.pop_back();
+            } else {
+                t++;
+            }
         }
 
-        imG = curve_->add(imG, mG);
+        curve_->add(Q, step);
     }
 
-    throw std::invalid_argument("Could not find k such that kG = P, increase memory limit");
+    std::sort(index.begin(), index.end());
+    return index;
 }
 
 /**
- * Fills the given hash map with points, { jG | 1 <= j <= min(m, MEMORY_LIMIT) }, mapping
- * to their multiplier, j.
+ * Pohlig-Hellman: with n the order of G, for each prime power q^e dividing n,
+ * k mod q^e is found one base-q digit at a time by solving in the subgroup of
+ * order q,
+ *   d_i (n/q)G = (n/q^{i+1})(P - x_i G),  x_{i+1} = x_i + d_i q^i,
+ * and the residues are combined with the Chinese remainder theorem. The cost
+ * is dominated by \sqrt{q} for the largest prime q instead of \sqrt{n}. Each
+ * target is delivered as soon as its last digit is found. Returns the indices
+ * of the targets that were not found.
  */
-void Elliptic::BabyGiant::populateTable(std::unordered_map<Point, long, PointHasher>& table,
-        const Point& G, mpz_class m) {
+std::vector<std::size_t> Elliptic::BabyGiant::pohligHellman(const Point& G,
+        const std::vector<Point>& P,
+        const std::function<void(std::size_t, const mpz_class&)>& resolved) {
+    // The order of G is the smallest divisor n of the curve order with nG = 0
+    mpz_class n = getOrder();
+    std::vector<Factor> factors;
+    for (Factor factor : getFactors()) {
+        while (factor.second > 0 && multiply(G, n / factor.first).isZero()) {
+            n /= factor.first;
+            factor.second--;
+        }
+
+        if (factor.second > 0) {
+            factors.push_back(factor);
+        }
+    }
+
+    std::vector<mpz_class> k(P.size(), 0);
+    std::vector<bool> failed(P.size(), false), delivered(P.size(), false);
+
+    // Residues can also match for targets outside the subgroup of G
+    auto deliver = [&](std::size_t t, const mpz_class& kt) {
+        delivered[t] = true;
+        if (multiply(G, kt) == P[t]) {
+            resolved(t, kt);
+        } else {
+            failed[t] = true;
+        }
+    };
+
+    mpz_class modulus = 1;
+    for (std::size_t f = 0; f < factors.size(); f++) {
+        const mpz_class& q = factors[f].first;
+        mpz_class qe;
+        mpz_pow_ui(qe.get_mpz_t(), q.get_mpz_t(), factors[f].second);
+
+        // k = k (mod modulus) and k = x (mod q^e)
+        mpz_class inv;
+        mpz_invert(inv.get_mpz_t(), modulus.get_mpz_t(), qe.get_mpz_t());
+        std::vector<mpz_class> x(P.size(), 0);
+        auto combine = [&](std::size_t t) {
+            mpz_class c = (x[t] - k[t])*inv;
+            mpz_mod(c.get_mpz_t(), c.get_mpz_t(), qe.get_mpz_t());
+            return mpz_class(k[t] + modulus*c);
+        };
+
+        Point gamma = multiply(G, n / q);
+        mpz_class qi = 1; // q^i
+        for (unsigned long i = 0; i < factors[f].second; i++) {
+            mpz_class cofactor = n / (qi*q);
+            bool last = f + 1 == factors.size() && i + 1 == factors[f].second;
+
+            std::vector<Point> h;
+            h.reserve(P.size());
+            for (std::size_t t = 0; t < P.size(); t++) {
+                if (failed[t]) {
+                    h.push_back(Point());
+                    continue;
+                }
+
+                Point Q = curve_->add(P[t], curve_->negatePoint(multiply(G, x[t])));
+                h.push_back(multiply(Q, cofactor));
+            }
+
+            auto found = [&](std::size_t t, const mpz_class& d) {
+                x[t] += d*qi;
+                if (last && !failed[t]) {
+                    deliver(t, combine(t));
+                }
+            };
+
+            std::vector<std::size_t> unresolved = solve(gamma, q, h, found);
+            for (std::size_t t : unresolved) {
+                failed[t] = true;
+            }
+
+            qi *= q;
+        }
+
+        for (std::size_t t = 0; t < P.size(); t++) {
+            k[t] = combine(t);
+        }
+
+        modulus *= qe;
+    }
+
+    std::vector<std::size_t> unresolved;
+    for (std::size_t t = 0; t < P.size(); t++) {
+        if (!failed[t] && !delivered[t]) {
+            deliver(t, k[t]); // G is the identity
+        }
+
+        if (failed[t]) {
+            unresolved.push_back(t);
+        }
+    }
+
+    return unresolved;
+}
+
+/**
+ * Computes kP allowing k = 0 (mod n).
+ */
+Elliptic::Point Elliptic::BabyGiant::multiply(const Point& p, const mpz_class& k) {
+    mpz_class r = k;
+    mpz_mod(r.get_mpz_t(), r.get_mpz_t(), getOrder().get_mpz_t());
+    if (sgn(r) == 0 || p.isZero()) {
+        return Point();
+    }
+
+    return curve_->multiply(p, r);
+}
+
+/**
+ * The curve order is cached since the default `Curve::getOrder` is expensive.
+ */
+mpz_class Elliptic::BabyGiant::getOrder() {
+    if (sgn(order_) == 0) {
+        order_ = curve_->getOrder();
+    }
+
+    return order_;
+}
+
+/**
+ * Prime factorization of the curve order, cached alongside it.
+ */
+const std::vector<Elliptic::BabyGiant::Factor>& Elliptic::BabyGiant::getFactors() {
+    if (factors_.empty()) {
+        factors_ = factor(getOrder());
+    }
+
+    return factors_;
+}
+
+/**
+ * Giant step size, m = ceil(sqrt(n)).
+ */
+mpz_class Elliptic::BabyGiant::getStepSize(const mpz_class& n) {
+    return sqrt(n) + 1;
+}
+
+/**
+ * Returns the table of baby steps { jG | 1 <= j <= min(m, MEMORY_LIMIT) },
+ * building it only if no cached table matches the base point.
+ */
+const Elliptic::BabyStepTable& Elliptic::BabyGiant::getTable(const Point& G,
+        const mpz_class& m) {
+    for (const std::unique_ptr<BabyStepTable>& table : tables_) {
+        if (table->matches(*curve_, G, m)) {
+            return *table;
+        }
+    }
+
+    ELLIPTIC_TIMER(BABY_STEPS);
+
     long size = MEMORY_LIMIT;
     if (cmp(MEMORY_LIMIT, m) > 0) {
         size = m.get_si();
     }
 
-    Point jG;
-    for (long j = 1; j <= size; j++) {
-        jG = curve_->add(jG, G);
-        table[jG] = j;
+    return cacheTable(std::unique_ptr<BabyStepTable>(new BabyStepTable(*curve_, G, m, size)));
+}
+
+/**
+ * Keeps a table for later queries, evicting the oldest beyond TABLE_CACHE.
+ */
+const Elliptic::BabyStepTable& Elliptic::BabyGiant::cacheTable(
+        std::unique_ptr<BabyStepTable> table) {
+    if (tables_.size() >= TABLE_CACHE) {
+        tables_.erase(tables_.begin());
     }
+
+    tables_.push_back(std::move(table));
+    return *tables_.back();
 }
 
 /**
- * Get a uniform random number in 1 to n, inclusive. Seeding is done by the
- * system time. This method should NOT be used to generate random numbers for
- * private keys (consider using `getRandom` in "hash.h" which relies on /dev/random).
+ * Factors n into primes by trial division followed by Pollard's rho. Cofactors
+ * that rho fails to split are kept whole, baby-step giant-step does not rely on
+ * the subgroup order being prime.
  */
-mpz_class Elliptic::BabyGiant::getRandom(mpz_class n) {
-    gmp_randstate_t state;
-    gmp_randinit_mt(state);
+std::vector<Elliptic::BabyGiant::Factor> Elliptic::BabyGiant::factor(mpz_class n) {
+    std::vector<mpz_class> primes;
+    for (unsigned long d = 2; d < TRIAL_DIVISION && cmp(n, 1) > 0; d++) {
+        while (mpz_divisible_ui_p(n.get_mpz_t(), d) != 0) {
+            primes.push_back(d);
+            mpz_divexact_ui(n.get_mpz_t(), n.get_mpz_t(), d);
+        }
+    }
+
+    std::vector<mpz_class> composites;
+    if (cmp(n, 1) > 0) {
+        composites.push_back(n);
+    }
+
+    while (!composites.empty()) {
+        mpz_class c = composites.back();
+        composites.pop_back();
 
-    std::srand(std::time(NULL));
-    gmp_randseed_ui(state, std::rand());
+        mpz_class d;
+        if (mpz_probab_prime_p(c.get_mpz_t(), 25) != 0 || sgn(d = findFactor(c)) == 0) {
+            primes.push_back(c);
+        } else {
+            composites.push_back(d);
+            composites.push_back(c / d);
+        }
+    }
 
-    mpz_class random;
-    mpz_urandomm(random.get_mpz_t(), state, n.get_mpz_t());
+    std::sort(primes.begin(), primes.end());
 
-    gmp_randclear(state);
+    std::vector<Factor> factors;
+    for (const mpz_class& p : primes) {
+        if (!factors.empty() && factors.back().first == p) {
+            factors.back().second++;
+        } else {
+            factors.push_back(Factor(p, 1));
+        }
+    }
 
-    return random + 1; // Add 1 since `mpz_urandomm` generates 0 to n - 1
+    return factors;
+}
+
+/**
+ * Pollard's rho with Floyd's cycle detection. Returns a non-trivial factor of
+ * the composite n, or zero if none was found within RHO_ITERATIONS.
+ */
+mpz_class Elliptic::BabyGiant::findFactor(const mpz_class& n) {
+    for (unsigned long c = 1; c < 16; c++) {
+        mpz_class x = 2, y = 2, d = 1;
+        for (unsigned long i = 0; i < RHO_ITERATIONS && d == 1; i++) {
+            // x = f(x), y = f(f(y)) where f(z) = z^2 + c (mod n)
+            x = x*x + c;
+            mpz_mod(x.get_mpz_t(), x.get_mpz_t(), n.get_mpz_t());
+            for (int j = 0; j < 2; j++) {
+                y = y*y + c;
+                mpz_mod(y.get_mpz_t(), y.get_mpz_t(), n.get_mpz_t());
+            }
+
+            d = gcd(x - y, n);
+        }
+
+        if (d != 1 && d != n) {
+            return d;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Get a uniform random number in 1 to n, inclusive, from the fast non-crypto
+ * generator. This method should NOT be used to generate random numbers for
+ * private keys (consider using `Random` in "random.h").
+ */
+mpz_class Elliptic::BabyGiant::getRandom(mpz_class n) {
+    return FastRandom::local().uniform(n) + 1;
 }
 
@@ -0,0 +1,200 @@
+#include "babysteptable.h"
+
+#include <algorithm> // std::equal_range, std::min, std::sort
+#include <cstdio>    // std::remove, std::rename
+#include <cstring>   // std::memcmp, std::memcpy
+#include <fstream>   // std::ofstream
+#include <stdexcept> // std::runtime_error
+
+#include <fcntl.h>    // open
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
+
+const char Elliptic::BabyStepTable::MAGIC[8] = { 'E', 'B', 'S', 'G', 'T', 'B', 'L', '1' };
+
+namespace {
+
+    // File layout (native byte order): magic, key length, entry count, key
+    // padded to a multiple of 16 bytes, entries sorted by fingerprint.
+    struct Header {
+        char magic[8];
+        std::uint64_t keyLength;
+        std::uint64_t count;
+    };
+
+    std::size_t padded(std::size_t length) {
+        return (length + 15) & ~static_cast<std::size_t>(15);
+    }
+
+    bool byFingerprint(const Elliptic::BabyStepTable::Entry& a,
+            const Elliptic::BabyStepTable::Entry& b) {
+        return a.fingerprint < b.fingerprint;
+    }
+
+}
+
+/**
+ * Builds the table in memory by repeated addition of G.
+ */
+Elliptic::BabyStepTable::BabyStepTable(const Curve& curve, const Point& G,
+        const mpz_class& m, long size) : key_(makeKey(curve, G, m)), mapping_(nullptr),
+        mappingLength_(0) {
+    entries_.reserve(size);
+
+    Point jG;
+    for (long j = 1; j <= size; j++) {
+        jG = curve.add(jG, G);
+        entries_.push_back({ fingerprint(jG), static_cast<std::uint64_t>(j) });
+    }
+
+    std::sort(entries_.begin(), entries_.end(), byFingerprint);
+
+    begin_ = entries_.data();
+    size_ = entries_.size();
+}
+
+/**
+ * Memory-maps a table previously written by `save`. Pages are shared between
+ * all processes mapping the same file.
+ */
+Elliptic::BabyStepTable::BabyStepTable(const std::string& path) : mapping_(nullptr),
+        mappingLength_(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open baby-step table " + path);
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(Header)) {
+        close(fd);
+        throw std::runtime_error(path + " is not a baby-step table");
+    }
+
+    mappingLength_ = status.st_size;
+    mapping_ = mmap(nullptr, mappingLength_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        throw std::runtime_error("Unable to map baby-step table " + path);
+    }
+
+    const char* base = static_cast<const char*>(mapping_);
+    Header header;
+    std::memcpy(&header, base, sizeof(Header));
+
+    // Checked by division so that crafted lengths and counts cannot overflow
+    std::size_t offset = sizeof(Header) + padded(std::min<std::uint64_t>(header.keyLength, mappingLength_));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+            || header.keyLength > mappingLength_ - sizeof(Header) || offset > mappingLength_
+            || (mappingLength_ - offset) % sizeof(Entry) != 0
+            || header.count != (mappingLength_ - offset) / sizeof(Entry)) {
+        munmap(mapping_, mappingLength_);
+        throw std::runtime_error(path + " is not a baby-step table");
+    }
+
+    key_.assign(base + sizeof(Header), header.keyLength);
+    begin_ = reinterpret_cast<const Entry*>(base + offset);
+    size_ = header.count;
+}
+
+Elliptic::BabyStepTable::~BabyStepTable() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mappingLength_);
+    }
+}
+
+/**
+ * Checks whether the table holds the baby steps of G for giant step size m.
+ */
+bool Elliptic::BabyStepTable::matches(const Curve& curve, const Point& G,
+        const mpz_class& m) const {
+    return key_ == makeKey(curve, G, m);
+}
+
+/**
+ * Checks whether the table was built on the given curve.
+ */
+bool Elliptic::BabyStepTable::matches(const Curve& curve) const {
+    std::string prefix = curveKey(curve);
+    return key_.compare(0, prefix.length(), prefix) == 0;
+}
+
+/**
+ * Returns the entries whose fingerprint matches Q. Fingerprints may collide so
+ * a match must be verified by the caller.
+ */
+std::pair<const Elliptic::BabyStepTable::Entry*, const Elliptic::BabyStepTable::Entry*>
+        Elliptic::BabyStepTable::find(const Point& Q) const {
+    Entry target = { fingerprint(Q), 0 };
+    return std::equal_range(begin_, begin_ + size_, target, byFingerprint);
+}
+
+/**
+ * Writes the table to disk so it can later be memory-mapped. The file is
+ * written next to `path` and renamed over it, so processes (including this
+ * one) that have the old file mapped keep reading intact pages.
+ */
+void Elliptic::BabyStepTable::save(const std::string& path) const {
+    std::string temporary = path + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.keyLength = key_.length();
+    header.count = size_;
+
+    std::string key = key_;
+    key.resize(padded(key.length()), '\0');
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    out.write(key.data(), key.length());
+    out.write(reinterpret_cast<const char*>(begin_), size_*sizeof(Entry));
+    out.close();
+    if (!out || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Unable to write baby-step table " + path);
+    }
+}
+
+namespace {
+
+    // Least significant 64 bits of |x| whatever the limb width of the platform
+    std::uint64_t low64(mpz_srcptr x) {
+#if GMP_LIMB_BITS >= 64
+        return mpz_getlimbn(x, 0);
+#else
+        std::uint64_t low = 0;
+        for (int i = 0; i < 64 / GMP_LIMB_BITS; i++) {
+            low |= static_cast<std::uint64_t>(mpz_getlimbn(x, i)) << (i*GMP_LIMB_BITS);
+        }
+
+        return low;
+#endif
+    }
+
+}
+
+/**
+ * Mixes the low 64 bits of both coordinates (splitmix64 finalizer). The
+ * result depends neither on the process nor on the GMP limb width, so tables
+ * can be stored on disk and moved between platforms of the same byte order.
+ */
+std::uint64_t Elliptic::BabyStepTable::fingerprint(const Point& p) {
+    std::uint64_t h = low64(p.getX().get_mpz_t());
+    h ^= low64(p.getY().get_mpz_t()) * 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    return h ^ (h >> 31);
+}
+
+std::string Elliptic::BabyStepTable::curveKey(const Curve& curve) {
+    return curve.getA().get_str() + ":" + curve.getB().get_str() + ":"
+        + curve.getPrime().get_str(16) + ":";
+}
+
+std::string Elliptic::BabyStepTable::makeKey(const Curve& curve, const Point& G,
+        const mpz_class& m) {
+    return curveKey(curve) + G.getX().get_str(16) + ":" + G.getY().get_str(16) + ":"
+        + m.get_str(16);
+}
@@ -6,12 +6,16 @@
 
 #include <gmpxx.h>
 
+#include "instrument.h"
+
 const std::string Elliptic::Base58::BASE58 = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
 
 /**
  * Converts a hexadecimal string to Base58.
  */
 std::string Elliptic::Base58::hexToBase58(const std::string& input) {
+    ELLIPTIC_COUNT(ENCODES);
+
     mpz_class n;
     if (n.set_str(input, 16) != 0) {
         throw std::invalid_argument(input + " is an invalid hex string");
@@ -0,0 +1,83 @@
+#include "basetable.h"
+
+#include <stdexcept> // std::invalid_argument
+
+const int Elliptic::BaseTable::WINDOW = 4;
+
+/**
+ * Builds the table for scalars up to the bit length of the prime plus one,
+ * which covers the order of any point on the curve (Hasse's theorem).
+ */
+Elliptic::BaseTable::BaseTable(const Curve& curve, const Point& G) : curve_(curve), G_(G) {
+    std::size_t bits = mpz_sizeinbase(curve.getPrime().get_mpz_t(), 2) + 1;
+    windows_ = (bits + WINDOW - 1) / WINDOW;
+
+    const int digits = (1 << WINDOW) - 1;
+    table_.reserve(windows_*digits);
+
+    Point base = G; // 16^i G
+    for (std::size_t i = 0; i < windows_; i++) {
+        Point multiple = base;
+        for (int d = 1; d <= digits; d++) {
+            table_.push_back(multiple);
+            multiple = curve_.add(multiple, base);
+        }
+
+        base = multiple; // 16 16^i G
+    }
+}
+
+/**
+ * Computes kG for 0 < k < 2^(4 windows). A lone scalar gains nothing from
+ * sharing inversions, so it goes through the curve's own scalar multiplication
+ * (Jacobian coordinates with a single inversion on the field backends) rather
+ * than one affine addition, and inversion, per window.
+ */
+Elliptic::Point Elliptic::BaseTable::multiply(const mpz_class& k) const {
+    if (sgn(k) <= 0 || mpz_sizeinbase(k.get_mpz_t(), 2) > windows_*WINDOW) {
+        throw std::invalid_argument("Scalar is out of range of the base table");
+    }
+
+    return curve_.multiply(G_, k);
+}
+
+/**
+ * Computes k_i G for every scalar, adding the table entry of each window to
+ * all of the accumulators in one batched addition.
+ */
+std::vector<Elliptic::Point> Elliptic::BaseTable::multiply(const std::vector<mpz_class>& k) const {
+    for (const mpz_class& ki : k) {
+        if (sgn(ki) <= 0 || mpz_sizeinbase(ki.get_mpz_t(), 2) > windows_*WINDOW) {
+            throw std::invalid_argument("Scalar is out of range of the base table");
+        }
+    }
+
+    std::vector<Point> result(k.size()), entries(k.size());
+    for (std::size_t i = 0; i < windows_; i++) {
+        for (std::size_t t = 0; t < k.size(); t++) {
+            entries[t] = entry(i, k[t]);
+        }
+
+        curve_.add(result, entries);
+    }
+
+    return result;
+}
+
+/**
+ * Table entry for the i-th 4-bit window of k, or the identity for a zero digit.
+ */
+const Elliptic::Point& Elliptic::BaseTable::entry(std::size_t window, const mpz_class& k) const {
+    static const Point ZERO;
+
+    unsigned long digit = 0;
+    for (int b = WINDOW - 1; b >= 0; b--) {
+        digit = digit << 1 | mpz_tstbit(k.get_mpz_t(), window*WINDOW + b);
+    }
+
+    if (digit == 0) {
+        return ZERO;
+    }
+
+    return table_[window*((1 << WINDOW) - 1) + digit - 1];
+}
@@ -0,0 +1,320 @@
+#include "bip32.h"
+
+#include <stdexcept> // std::invalid_argument
+
+#include "base58.h"
+
+const std::uint32_t Elliptic::Bip32::HARDENED = 0x80000000;
+
+const std::string Elliptic::Bip32::SEED_KEY = "426974636F696E2073656564"; // "Bitcoin seed"
+const std::string Elliptic::Bip32::XPRV = "0488ADE4";
+const std::string Elliptic::Bip32::XPUB = "0488B21E";
+
+Elliptic::Bip32::Bip32(std::size_t cacheSize) : table_(curve_, bitcoin_.getBasePoint()),
+        cacheSize_(cacheSize), hits_(0) {}
+
+/**
+ * Generates the master key from a hexadecimal seed (16 to 64 bytes).
+ */
+Elliptic::ExtendedKey Elliptic::Bip32::master(const std::string& seed) const {
+    if (seed.length() < 32 || seed.length() > 128) {
+        throw std::invalid_argument("Seed must be between 16 and 64 bytes");
+    }
+
+    std::string I = Bitcoin::toUpperCase(Hash::hmacSha512(SEED_KEY, seed));
+
+    ExtendedKey key;
+    key.depth = 0;
+    key.parentFingerprint = 0;
+    key.childNumber = 0;
+    key.chainCode = I.substr(64);
+    key.privateKey.set_str(I.substr(0, 64), 16);
+    if (sgn(key.privateKey) == 0 || cmp(key.privateKey, curve_.getOrder()) >= 0) {
+        throw std::invalid_argument("Seed produces an invalid master key");
+    }
+
+    key.publicKey = table_.multiply(key.privateKey);
+    return key;
+}
+
+/**
+ * Derives child `index` of the parent. Private parents give private children
+ * (CKDpriv); public parents give public children (CKDpub) and cannot derive
+ * hardened indices (index >= HARDENED).
+ */
+Elliptic::ExtendedKey Elliptic::Bip32::derive(const ExtendedKey& parent,
+        std::uint32_t index) const {
+    if (!parent.isPrivate() && index >= HARDENED) {
+        throw std::invalid_argument("Hardened children require a private parent key");
+    }
+
+    std::string I = Bitcoin::toUpperCase(childHmac(parent, index));
+    mpz_class IL;
+    IL.set_str(I.substr(0, 64), 16);
+
+    mpz_class n = curve_.getOrder();
+    if (cmp(IL, n) >= 0) {
+        throw std::invalid_argument("Child " + std::to_string(index) + " is invalid");
+    }
+
+    ExtendedKey child;
+    child.depth = parent.depth + 1;
+    child.parentFingerprint = fingerprint(parent);
+    child.childNumber = index;
+    child.chainCode = I.substr(64);
+
+    if (parent.isPrivate()) {
+        child.privateKey = IL + parent.privateKey;
+        mpz_mod(child.privateKey.get_mpz_t(), child.privateKey.get_mpz_t(), n.get_mpz_t());
+        if (sgn(child.privateKey) == 0) {
+            throw std::invalid_argument("Child " + std::to_string(index) + " is invalid");
+        }
+
+        child.publicKey = table_.multiply(child.privateKey);
+    } else {
+        // As in derivePublic, I_L = 0 is rejected rather than giving K_par
+        if (sgn(IL) == 0) {
+            throw std::invalid_argument("Child " + std::to_string(index) + " is invalid");
+        }
+
+        child.privateKey = 0;
+        child.publicKey = curve_.add(table_.multiply(IL), parent.publicKey);
+        if (child.publicKey.isZero()) {
+            throw std::invalid_argument("Child " + std::to_string(index) + " is invalid");
+        }
+    }
+
+    return child;
+}
+
+/**
+ * Derives a path such as m/44'/0'/0'/0/5 (or M/... from a public root) where
+ * ' or h marks hardened indices. Every intermediate node is cached, keyed by
+ * the root's public key and chain code and the path prefix.
+ */
+Elliptic::ExtendedKey Elliptic::Bip32::derive(const ExtendedKey& root, const std::string& path) {
+    if (path.empty() || (path[0] != 'm' && path[0] != 'M')) {
+        throw std::invalid_argument("Path must start with m");
+    }
+
+    std::vector<std::uint32_t> indices;
+    for (std::size_t start = 1; start < path.length();) {
+        if (path[start] != '/') {
+            throw std::invalid_argument("Path " + path + " is invalid");
+        }
+
+        std::size_t end = path.find('/', start + 1);
+        std::string part = path.substr(start + 1, end == std::string::npos ? end : end - start - 1);
+        start = end == std::string::npos ? path.length() : end;
+
+        bool hardened = !part.empty() && (part.back() == '\'' || part.back() == 'h');
+        if (hardened) {
+            part.pop_back();
+        }
+
+        if (part.empty() || part.find_first_not_of("0123456789") != std::string::npos
+                || part.length() > 10 || std::stoull(part) >= HARDENED) {
+            throw std::invalid_argument("Path " + path + " is invalid");
+        }
+
+        indices.push_back(std::stoul(part) + (hardened ? HARDENED : 0));
+    }
+
+    // Find the deepest cached prefix, then derive and cache the rest
+    std::string prefix = bitcoin_.pointToPublicKey(root.publicKey, true) + root.chainCode
+        + (root.isPrivate() ? "m" : "M");
+    std::vector<std::string> keys(1, prefix);
+    for (std::uint32_t index : indices) {
+        keys.push_back(keys.back() + "/" + std::to_string(index));
+    }
+
+    ExtendedKey node = root;
+    std::size_t depth = indices.size();
+    while (depth > 0 && !findCached(keys[depth], node)) {
+        depth--;
+    }
+
+    if (depth == 0) {
+        node = root;
+    }
+
+    for (; depth < indices.size(); depth++) {
+        node = derive(node, indices[depth]);
+        insertCached(keys[depth + 1], node);
+    }
+
+    return node;
+}
+
+/**
+ * Drops the private key, leaving the extended public key.
+ */
+Elliptic::ExtendedKey Elliptic::Bip32::neuter(const ExtendedKey& key) const {
+    ExtendedKey neutered = key;
+    neutered.privateKey = 0;
+    return neutered;
+}
+
+/**
+ * Derives the public keys of the non-hardened children first to first + count
+ * - 1. Each child is K_par + I_L G, where all of the I_L G are computed
+ * together from the base table, i.e., only point additions sharing one
+ * inversion per window, instead of a full scalar multiplication per child.
+ */
+std::vector<Elliptic::Point> Elliptic::Bip32::derivePublic(const ExtendedKey& parent,
+        std::uint32_t first, std::size_t count) const {
+    if (count > 0 && (first >= HARDENED || HARDENED - first < count)) {
+        throw std::invalid_argument("Range includes hardened children");
+    }
+
+    mpz_class n = curve_.getOrder();
+    ExtendedKey publicParent = neuter(parent);
+
+    std::vector<mpz_class> IL(count);
+    for (std::size_t i = 0; i < count; i++) {
+        IL[i].set_str(childHmac(publicParent, first + i).substr(0, 64), 16);
+        if (sgn(IL[i]) == 0 || cmp(IL[i], n) >= 0) {
+            throw std::invalid_argument("Child " + std::to_string(first + i) + " is invalid");
+        }
+    }
+
+    std::vector<Point> children = table_.multiply(IL);
+    curve_.add(children, parent.publicKey);
+
+    return children;
+}
+
+/**
+ * Addresses of the compressed public keys from `derivePublic`.
+ */
+std::vector<std::string> Elliptic::Bip32::deriveAddresses(const ExtendedKey& parent,
+        std::uint32_t first, std::size_t count) const {
+    std::vector<std::string> addresses;
+    addresses.reserve(count);
+    for (const Point& p : derivePublic(parent, first, count)) {
+        addresses.push_back(bitcoin_.pointToAddress(p, true));
+    }
+
+    return addresses;
+}
+
+/**
+ * Serializes to the Base58Check xprv/xpub format.
+ */
+std::string Elliptic::Bip32::serialize(const ExtendedKey& key) const {
+    std::string data = (key.isPrivate() ? XPRV : XPUB) + toHex(key.depth, 2)
+        + toHex(key.parentFingerprint, 8) + toHex(key.childNumber, 8) + key.chainCode;
+
+    if (key.isPrivate()) {
+        data += "00" + toHex(key.privateKey, 64);
+    } else {
+        data += bitcoin_.pointToPublicKey(key.publicKey, true);
+    }
+
+    std::string sha = Hash::sha256(Hash::sha256(data));
+    return Base58::hexToBase58(data + sha.substr(0, 8));
+}
+
+/**
+ * Parses a Base58Check xprv/xpub string, verifying the checksum and the key.
+ */
+Elliptic::ExtendedKey Elliptic::Bip32::parse(const std::string& extended) const {
+    std::string hex = Base58::base58ToHex(extended);
+    if (hex.length() > 164) {
+        throw std::invalid_argument("Extended key is invalid");
+    }
+
+    hex = std::string(164 - hex.length(), '0') + hex;
+    std::string sha = Hash::sha256(Hash::sha256(hex.substr(0, 156)));
+    if (hex.compare(156, 8, sha, 0, 8) != 0) {
+        throw std::invalid_argument("SHA-256 checksum is incorrect");
+    }
+
+    std::string version = Bitcoin::toUpperCase(hex.substr(0, 8));
+
+    if (version != XPRV && version != XPUB) {
+        throw std::invalid_argument("Extended key version is invalid");
+    }
+
+    ExtendedKey key;
+    key.depth = std::stoi(hex.substr(8, 2), 0, 16);
+    key.parentFingerprint = std::stoul(hex.substr(10, 8), 0, 16);
+    key.childNumber = std::stoul(hex.substr(18, 8), 0, 16);
+    key.chainCode = Bitcoin::toUpperCase(hex.substr(26, 64));
+
+    std::string keyData = hex.substr(90, 66);
+    if (version == XPRV) {
+        key.privateKey.set_str(keyData.substr(2), 16);
+        if (keyData.compare(0, 2, "00") != 0 || sgn(key.privateKey) == 0
+                || cmp(key.privateKey, curve_.getOrder()) >= 0) {
+            throw std::invalid_argument("Extended private key is invalid");
+        }
+
+        key.publicKey = table_.multiply(key.privateKey);
+    } else {
+        key.privateKey = 0;
+        key.publicKey = bitcoin_.getPoint(keyData);
+    }
+
+    return key;
+}
+
+bool Elliptic::Bip32::findCached(const std::string& key, ExtendedKey& node) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        return false;
+    }
+
+    cache_.splice(cache_.begin(), cache_, it->second);
+    node = it->second->second;
+    hits_++;
+    return true;
+}
+
+void Elliptic::Bip32::insertCached(const std::string& key, const ExtendedKey& node) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cacheSize_ == 0 || index_.count(key) != 0) {
+        return;
+    }
+
+    if (cache_.size() >= cacheSize_) {
+        index_.erase(cache_.back().first);
+        cache_.pop_back();
+    }
+
+    cache_.emplace_front(key, node);
+    index_[key] = cache_.begin();
+}
+
+/**
+ * HMAC-SHA512 of the parent chain code over 0x00 || k_par || index for
+ * hardened children and serP(K_par) || index otherwise.
+ */
+std::string Elliptic::Bip32::childHmac(const ExtendedKey& parent, std::uint32_t index) const {
+    std::string data;
+    if (index >= HARDENED) {
+        data = "00" + toHex(parent.privateKey, 64);
+    } else {
+        data = bitcoin_.pointToPublicKey(parent.publicKey, true);
+    }
+
+    return Hash::hmacSha512(parent.chainCode, data + toHex(index, 8));
+}
+
+/**
+ * First four bytes of HASH160 of the compressed public key.
+ */
+std::uint32_t Elliptic::Bip32::fingerprint(const ExtendedKey& key) const {
+    std::string hash160 = Hash::ripemd160(Hash::sha256(bitcoin_.pointToPublicKey(key.publicKey, true)));
+    return std::stoul(hash160.substr(0, 8), 0, 16);
+}
+
+/**
+ * Zero-padded upper case hexadecimal with the given number of digits.
+ */
+std::string Elliptic::Bip32::toHex(const mpz_class& n, std::size_t length) {
+    std::string hex = Bitcoin::toUpperCase(n.get_str(16));
+
+    return std::string(length > hex.length() ? length - hex.length() : 0, '0') + hex;
+}
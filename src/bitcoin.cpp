@@ -1,15 +1,23 @@
 #include "bitcoin.h"
 
-#include <algorithm> // std::transform
+#include <algorithm> // std::min, std::transform
+#include <cstdio>    // std::rename
 #include <cstdlib>   // std::system
+#include <fstream>   // std::ofstream
 #include <stdexcept> // std::runtime_error, std::invalid_argument
 
 #include "base58.h"
+#include "instrument.h"
+#include "parallel.h"
+#include "pdf.h"
+#include "qrcode.h"
+#include "random.h"
 
 const int Elliptic::Bitcoin::HEX_LENGTH = 64;
 const int Elliptic::Bitcoin::WIF_LENGTH = 51;
 const int Elliptic::Bitcoin::COMPRESSED = 66;
 const int Elliptic::Bitcoin::UNCOMPRESSED = 130;
+const int Elliptic::Bitcoin::WALLETS_PER_PAGE = 4;
 
 const std::string Elliptic::Bitcoin::BASE_POINT = "0479BE667EF9DCBBAC55A06295CE870B07029BFCDB2DCE28D959F2815B16F81798483ADA7726A3C4655DA4FBFC0E1108A8FD17B448A68554199C47D08FFB10D4B8";
 
@@ -22,6 +30,7 @@ void Elliptic::Bitcoin::paperWallet(const std::string& privateKey, bool compress
     std::string address = publicKeyToAddress(publicKey);
     std::string WIF = privateHexToWIF(privateHex, compressed);
 
+    ELLIPTIC_TIMER(RENDER);
     std::string command = "cd LaTeX/; sh generate.sh " + address + " " + WIF;
     if (std::system(command.c_str()) != 0) {
         throw std::runtime_error("Unable to generate paper wallet");
@@ -29,15 +38,111 @@ void Elliptic::Bitcoin::paperWallet(const std::string& privateKey, bool compress
 }
 
 /**
- * Generates a hexadecimal private key using the OpenSSL library.
+ * Generates a single PDF at `path` containing a paper wallet for each private
+ * key. Keys are derived in parallel, then the wallets are either typeset by
+ * one LaTeX compile, which needs the templates in LaTeX/ under the working
+ * directory, or drawn by the built-in PDF renderer, which needs no TeX
+ * installation and renders pages in parallel.
+ */
+void Elliptic::Bitcoin::paperWallets(const std::vector<std::string>& privateKeys,
+        bool compressed, Renderer renderer, const std::string& path) const {
+    std::size_t count = privateKeys.size();
+    std::vector<std::string> addresses(count), WIFs(count);
+    Parallel::forEach(count, [&](std::size_t i) {
+        std::string privateHex = convertToPrivateHex(privateKeys[i]);
+        addresses[i] = publicKeyToAddress(privateHexToPublicKey(privateHex, compressed));
+        WIFs[i] = privateHexToWIF(privateHex, compressed);
+    });
+
+    ELLIPTIC_TIMER(RENDER);
+    if (renderer == LATEX) {
+        std::ofstream list("LaTeX/wallets.tex", std::ios::trunc);
+        for (std::size_t i = 0; i < count; i++) {
+            list << "\\wallet{" << addresses[i] << "}{" << WIFs[i] << "}\n";
+        }
+
+        list.close();
+        if (!list || std::system("cd LaTeX/; sh generate.sh -b") != 0) {
+            throw std::runtime_error("Unable to generate paper wallets");
+        }
+
+        const std::string typeset = "LaTeX/paper-wallets.pdf";
+        if (path != typeset && std::rename(typeset.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("Unable to write " + path);
+        }
+
+        return;
+    }
+
+    std::size_t pages = (count + WALLETS_PER_PAGE - 1) / WALLETS_PER_PAGE;
+    std::vector<std::string> content(pages);
+    Parallel::forEach(pages, [&](std::size_t page) {
+        std::size_t begin = page*WALLETS_PER_PAGE;
+        std::size_t end = std::min(count, begin + WALLETS_PER_PAGE);
+        for (std::size_t i = begin; i < end; i++) {
+            double y = Pdf::LETTER_HEIGHT - 36 - (i - begin + 1)*162;
+            content[page] += drawWallet(addresses[i], WIFs[i], y);
+        }
+    });
+
+    Pdf pdf;
+    for (const std::string& page : content) {
+        pdf.addPage(page);
+    }
+
+    pdf.save(path);
+}
+
+/**
+ * PDF content stream for a 7.5 by 2 inch paper wallet with its bottom edge at
+ * y: the address and its QR code on the left, the WIF private key and its QR
+ * code on the right of a dashed fold line.
+ */
+std::string Elliptic::Bitcoin::drawWallet(const std::string& address, const std::string& WIF,
+        double y) {
+    const double left = 36, width = 540, height = 144, half = width / 2;
+
+    std::string ops = "0.5 w\n" + Pdf::rectangle(left, y, width, height);
+    ops += "[4 2] 0 d " + std::to_string(left + half) + " " + std::to_string(y) + " m "
+        + std::to_string(left + half) + " " + std::to_string(y + height) + " l S [] 0 d\n";
+
+    ops += Pdf::text(left + 12, y + height - 18, 10, "BITCOIN ADDRESS", true);
+    ops += Pdf::text(left + 12, y + height - 30, 9, address, true);
+    ops += Pdf::qrCode(QRCode(address), left + 12, y + 10, 96);
+    ops += Pdf::text(left + 120, y + 14, 7, "Share to receive funds");
+
+    ops += Pdf::text(left + half + 12, y + height - 18, 10, "PRIVATE KEY (WIF)", true);
+    ops += Pdf::text(left + half + 12, y + height - 30, 6, WIF, true);
+    ops += Pdf::qrCode(QRCode(WIF), left + half + 12, y + 10, 96);
+    ops += Pdf::text(left + half + 120, y + 14, 7, "Keep secret, spend funds");
+
+    return ops;
+}
+
+/**
+ * Generates a hexadecimal private key from the thread's CSPRNG.
  */
 std::string Elliptic::Bitcoin::generatePrivateHex() const {
-    std::string privateKey = hash_.getRandom(HEX_LENGTH / 2);
-    if (!validPrivateHex(privateKey)) {
-        throw std::runtime_error("Generated private key is invalid");
+    return generatePrivateHex(1)[0];
+}
+
+/**
+ * Generates hexadecimal private keys in bulk. The random scalars are drawn by
+ * rejection sampling against the curve order so they never need re-parsing.
+ */
+std::vector<std::string> Elliptic::Bitcoin::generatePrivateHex(std::size_t count) const {
+    ELLIPTIC_TIMER(GENERATE);
+
+    std::vector<Random::Scalar> scalars = Random::scalars(curve_->getOrder(), count);
+
+    std::vector<std::string> privateKeys;
+    privateKeys.reserve(count);
+    for (Random::Scalar& scalar : scalars) {
+        privateKeys.push_back(toUpperCase(hash_.byteToHex(scalar.data(), scalar.size())));
+        scalar.fill(0);
     }
 
-    return toUpperCase(privateKey);
+    return privateKeys;
 }
 
 /**
@@ -78,6 +183,8 @@ Elliptic::Point Elliptic::Bitcoin::getPoint(const std::string& point) const {
  * hexadecimal strings and verifies they lie within the order of the curve.
  */
 std::string Elliptic::Bitcoin::convertToPrivateHex(const std::string& privateKey) const {
+    ELLIPTIC_TIMER(CONVERT);
+
     std::size_t length = privateKey.length();
     std::string privateHex = privateKey;
     if (length == WIF_LENGTH || length == WIF_LENGTH + 1) {
@@ -98,6 +205,8 @@ std::string Elliptic::Bitcoin::convertToPrivateHex(const std::string& privateKey
  */
 std::string Elliptic::Bitcoin::privateHexToWIF(const std::string& privateKey,
         bool compressed) const {
+    ELLIPTIC_TIMER(WIF);
+
     if (!validPrivateHex(privateKey)) {
         throw std::invalid_argument("Private key is invalid");
     }
@@ -118,6 +227,8 @@ std::string Elliptic::Bitcoin::privateHexToWIF(const std::string& privateKey,
  */
 std::string Elliptic::Bitcoin::privateHexToPublicKey(const std::string& privateKey,
         bool compressed) const {
+    ELLIPTIC_TIMER(PUBLIC_KEY);
+
     if (!validPrivateHex(privateKey)) {
         throw std::invalid_argument("Private key is invalid");
     }
@@ -125,24 +236,61 @@ std::string Elliptic::Bitcoin::privateHexToPublicKey(const std::string& privateK
     mpz_class k;
     k.set_str(privateKey, 16);
 
-    Point p = curve_->multiply(getBasePoint(), k);
+    return pointToPublicKey(curve_->multiply(getBasePoint(), k), compressed);
+}
+
+/**
+ * Range of `count` private keys starting at privateKey (WIF, dice or
+ * hexadecimal) in steps of `stride`, all of which must be valid keys. The
+ * range refers to this object's curve.
+ */
+Elliptic::KeyRange Elliptic::Bitcoin::keyRange(const std::string& privateKey, std::uint64_t count,
+        const mpz_class& stride) const {
+    mpz_class first(convertToPrivateHex(privateKey), 16);
+    if (sgn(stride) <= 0 || (count > 0 && cmp(first + stride*(count - 1), curve_->getOrder()) >= 0)) {
+        throw std::invalid_argument("Key range exceeds the curve order");
+    }
 
-    std::string publicKey = "04" + pad(p.getX().get_str(16), HEX_LENGTH)
-        + pad(p.getY().get_str(16), HEX_LENGTH);
+    return KeyRange(*curve_, getBasePoint(), first, count, stride);
+}
 
+/**
+ * Converts a point on the curve to a hexadecimal public key.
+ */
+std::string Elliptic::Bitcoin::pointToPublicKey(const Point& p, bool compressed) const {
+    std::string x = toUpperCase(pad(p.getX().get_str(16), HEX_LENGTH));
     if (compressed) {
-        publicKey = compressPublicKey(publicKey);
+        return (mpz_even_p(p.getY().get_mpz_t()) != 0 ? "02" : "03") + x;
     }
 
-    return toUpperCase(publicKey);
+    return "04" + x + toUpperCase(pad(p.getY().get_str(16), HEX_LENGTH));
 }
 
 /**
  * Converts a hexadecimal public key to an address.
  */
 std::string Elliptic::Bitcoin::publicKeyToAddress(const std::string& publicKey) const {
+    ELLIPTIC_TIMER(ADDRESS);
+
     getPoint(publicKey); // Throws exception if public key is not valid
 
+    return encodeAddress(publicKey);
+}
+
+/**
+ * Converts a point on the curve to an address without re-parsing and
+ * validating its public key, e.g., for points from Curve::multiply.
+ */
+std::string Elliptic::Bitcoin::pointToAddress(const Point& p, bool compressed) const {
+    ELLIPTIC_TIMER(ADDRESS);
+
+    return encodeAddress(pointToPublicKey(p, compressed));
+}
+
+/**
+ * Hashes a valid hexadecimal public key into a Base58Check address.
+ */
+std::string Elliptic::Bitcoin::encodeAddress(const std::string& publicKey) const {
     std::string sha = hash_.sha256(publicKey);
     std::string rip = hash_.ripemd160(sha);
     rip = "00" + rip;
@@ -0,0 +1,456 @@
+#include "cli.h"
+
+#include <algorithm> // std::max, std::min
+#include <atomic>    // std::atomic
+#include <chrono>    // std::chrono::microseconds
+#include <csignal>   // SIGINT, SIGTERM
+#include <cstring>   // std::memchr
+#include <memory>    // std::unique_ptr
+#include <stdexcept> // std::invalid_argument, std::runtime_error
+
+#include <fcntl.h>    // open
+#include <signal.h>   // sigaction
+#include <sys/mman.h> // mmap, madvise, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
+
+#include "parallel.h"
+#include "pipeline.h"
+#include "server.h"
+
+const std::size_t Elliptic::Cli::BATCH = 1024;
+
+const char* const Elliptic::Cli::USAGE =
+    "Usage: elliptic <command> [options] [file]\n"
+    "\n"
+    "Reads one record per line from file, or standard input if there is none or\n"
+    "it is -, and writes one line per record in the same order.\n"
+    "\n"
+    "Commands:\n"
+    "  generate            Generate random hexadecimal private keys\n"
+    "  convert             Convert WIF, dice or hexadecimal private keys to hexadecimal\n"
+    "  derive              Derive public keys, or addresses, of private keys\n"
+    "  compress            Compress uncompressed public keys\n"
+    "  uncompress          Uncompress compressed public keys\n"
+    "  serve               Serve derivation requests on a Unix socket until interrupted\n"
+    "  load                Send random derivation requests to a server and report latency\n"
+    "\n"
+    "Options:\n"
+    "  -n, --count N       Number of keys to generate (default 1) or requests to send\n"
+    "                      (default 100000)\n"
+    "  -a, --address       Derive addresses instead of public keys\n"
+    "  -u, --uncompressed  Derive uncompressed public keys\n"
+    "  -t, --threads N     Worker threads per stage (default one per core)\n"
+    "  -s, --socket PATH   Server socket (default elliptic.sock)\n"
+    "  -b, --batch N       Largest batch the server derives at once (default 256)\n"
+    "  -d, --deadline N    Microseconds a request may wait for its batch (default 200)\n"
+    "  -c, --connections N Load generator connections (default 4)\n"
+    "      --depth N       Requests in flight per connection (default 64)\n";
+
+namespace {
+
+    /**
+     * Lines of a memory-mapped file or of a stream, without line terminators.
+     */
+    class Records {
+    public:
+        explicit Records(std::istream& in) : in_(&in), data_(nullptr), size_(0), offset_(0) {}
+        explicit Records(const std::string& path);
+        ~Records();
+
+        Records(const Records&) = delete;
+        Records& operator=(const Records&) = delete;
+
+        bool next(std::string& line);
+    private:
+        std::istream* in_;
+        const char* data_;
+        std::size_t size_, offset_;
+    };
+
+    Records::Records(const std::string& path) : in_(nullptr), data_(nullptr), size_(0), offset_(0) {
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat status;
+        if (fd < 0 || fstat(fd, &status) != 0) {
+            if (fd >= 0) {
+                close(fd);
+            }
+
+            throw std::runtime_error("Unable to open " + path);
+        }
+
+        size_ = static_cast<std::size_t>(status.st_size);
+        if (size_ > 0) {
+            void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Unable to map " + path);
+            }
+
+            madvise(data, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(data);
+        }
+
+        close(fd);
+    }
+
+    Records::~Records() {
+        if (data_ != nullptr) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    bool Records::next(std::string& line) {
+        if (in_ != nullptr) {
+            if (!std::getline(*in_, line)) {
+                return false;
+            }
+        } else {
+            if (offset_ >= size_) {
+                return false;
+            }
+
+            const char* begin = data_ + offset_;
+            const char* end = static_cast<const char*>(std::memchr(begin, '\n', size_ - offset_));
+            std::size_t length = end != nullptr ? end - begin : size_ - offset_;
+            line.assign(begin, length);
+            offset_ += length + 1;
+        }
+
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        return true;
+    }
+
+    unsigned long long number(const std::string& option, const std::string& value) {
+        std::size_t end = 0;
+        unsigned long long n = 0;
+        try {
+            n = std::stoull(value, &end);
+        } catch (const std::exception&) {
+            end = 0;
+        }
+
+        if (value.empty() || value[0] == '-' || end != value.length()) {
+            throw std::invalid_argument("Option " + option + " requires a number");
+        }
+
+        return n;
+    }
+
+    std::atomic<Elliptic::Server*> serving(nullptr);
+
+    void interrupt(int) {
+        Elliptic::Server* server = serving;
+        if (server != nullptr) {
+            server->stop();
+        }
+    }
+
+}
+
+Elliptic::Cli::Cli(std::istream& in, std::ostream& out, std::ostream& err)
+    : in_(in), out_(out), err_(err), table_(curve_, bitcoin_.getBasePoint()) {}
+
+/**
+ * Runs the command in args (without the program name) and returns the exit
+ * status: 0 on success, 1 if any record or the input failed and 2 for usage
+ * errors.
+ */
+int Elliptic::Cli::run(const std::vector<std::string>& args) {
+    Options options;
+    try {
+        options = parse(args);
+    } catch (const std::invalid_argument& e) {
+        err_ << "elliptic: " << e.what() << "\n\n" << USAGE;
+        return 2;
+    }
+
+    if (options.command == "help") {
+        out_ << USAGE;
+        return 0;
+    }
+
+    try {
+        if (options.command == "serve") {
+            serve(options);
+            return 0;
+        }
+
+        if (options.command == "load") {
+            return load(options) ? 0 : 1;
+        }
+
+        return stream(options) ? 0 : 1;
+    } catch (const std::exception& e) {
+        err_ << "elliptic: " << e.what() << "\n";
+        return 1;
+    }
+}
+
+Elliptic::Cli::Options Elliptic::Cli::parse(const std::vector<std::string>& args) {
+    Options options = { "", "", Parallel::threads(), 0, true, false, "elliptic.sock", 256, 200, 4, 64 };
+    if (args.empty()) {
+        throw std::invalid_argument("Missing command");
+    }
+
+    options.command = args[0];
+    if (options.command == "-h" || options.command == "--help") {
+        options.command = "help";
+    }
+
+    if (options.command != "help" && options.command != "generate" && options.command != "convert"
+            && options.command != "derive" && options.command != "compress"
+            && options.command != "uncompress" && options.command != "serve" && options.command != "load") {
+        throw std::invalid_argument("Unknown command " + options.command);
+    }
+
+    options.count = options.command == "load" ? 100000 : 1;
+    for (std::size_t i = 1; i < args.size(); i++) {
+        const std::string& arg = args[i];
+        bool valued = arg == "-n" || arg == "--count" || arg == "-t" || arg == "--threads" || arg == "-b"
+            || arg == "--batch" || arg == "-d" || arg == "--deadline" || arg == "-c" || arg == "--connections"
+            || arg == "--depth";
+        if (valued && i + 1 == args.size()) {
+            throw std::invalid_argument("Option " + arg + " requires a number");
+        }
+
+        if ((arg == "-s" || arg == "--socket") && i + 1 == args.size()) {
+            throw std::invalid_argument("Option " + arg + " requires a path");
+        }
+
+        if (arg == "-n" || arg == "--count") {
+            options.count = number(arg, args[++i]);
+        } else if (arg == "-t" || arg == "--threads") {
+            options.threads = static_cast<unsigned>(std::max(1ull, number(arg, args[++i])));
+        } else if (arg == "-s" || arg == "--socket") {
+            options.socket = args[++i];
+        } else if (arg == "-b" || arg == "--batch") {
+            options.batch = std::max(1ull, number(arg, args[++i]));
+        } else if (arg == "-d" || arg == "--deadline") {
+            options.deadline = number(arg, args[++i]);
+        } else if (arg == "-c" || arg == "--connections") {
+            options.connections = std::max(1ull, number(arg, args[++i]));
+        } else if (arg == "--depth") {
+            options.depth = std::max(1ull, number(arg, args[++i]));
+        } else if (arg == "-a" || arg == "--address") {
+            options.address = true;
+        } else if (arg == "-u" || arg == "--uncompressed") {
+            options.compressed = false;
+        } else if (arg.length() > 1 && arg[0] == '-') {
+            throw std::invalid_argument("Unknown option " + arg);
+        } else if (options.path.empty()) {
+            options.path = arg;
+        } else {
+            throw std::invalid_argument("Only one input file is supported");
+        }
+    }
+
+    return options;
+}
+
+/**
+ * Calls f(i) for every record of the batch that has not failed yet, recording
+ * the message of any exception as the record's error.
+ */
+template <class F>
+void Elliptic::Cli::each(Batch& batch, F f) {
+    batch.output.resize(batch.records.size());
+    for (std::size_t i = 0; i < batch.records.size(); i++) {
+        if (!batch.errors[i].empty()) {
+            continue;
+        }
+
+        try {
+            f(i);
+        } catch (const std::exception& e) {
+            batch.errors[i] = e.what();
+        }
+    }
+}
+
+/**
+ * Streams the records through the stages of the command. Returns false if any
+ * record failed.
+ */
+bool Elliptic::Cli::stream(const Options& options) {
+    Pipeline<Batch> pipeline;
+    std::unique_ptr<Records> records;
+    Pipeline<Batch>::Source source;
+
+    if (options.command == "generate") {
+        unsigned long long remaining = options.count;
+        source = [remaining](Batch& batch) mutable {
+            std::size_t n = static_cast<std::size_t>(std::min<unsigned long long>(remaining, BATCH));
+            remaining -= n;
+            batch.errors.resize(n);
+            batch.blank.resize(n);
+            return n > 0;
+        };
+    } else {
+        if (options.path.empty() || options.path == "-") {
+            records.reset(new Records(in_));
+        } else {
+            records.reset(new Records(options.path));
+        }
+
+        std::size_t line = 0;
+        source = [&records, line](Batch& batch) mutable {
+            std::string record;
+            while (batch.records.size() < BATCH && records->next(record)) {
+                // Blank lines pass through as records that every stage skips
+                bool blank = record.find_first_not_of(" \t") == std::string::npos;
+                batch.lines.push_back(++line);
+                batch.records.push_back(record);
+                batch.errors.push_back(blank ? "Blank line" : "");
+                batch.blank.push_back(blank);
+            }
+
+            return !batch.records.empty();
+        };
+    }
+
+    const Bitcoin& bitcoin = bitcoin_;
+    if (options.command == "generate") {
+        pipeline.addStage([&bitcoin](Batch& batch) {
+            batch.output = bitcoin.generatePrivateHex(batch.errors.size());
+        }, options.threads);
+    } else if (options.command == "convert") {
+        pipeline.addStage([&bitcoin](Batch& batch) {
+            each(batch, [&](std::size_t i) {
+                batch.output[i] = bitcoin.convertToPrivateHex(batch.records[i]);
+            });
+        }, options.threads);
+    } else if (options.command == "compress") {
+        pipeline.addStage([&bitcoin](Batch& batch) {
+            each(batch, [&](std::size_t i) {
+                batch.output[i] = bitcoin.compressPublicKey(batch.records[i]);
+            });
+        }, options.threads);
+    } else if (options.command == "uncompress") {
+        pipeline.addStage([&bitcoin](Batch& batch) {
+            each(batch, [&](std::size_t i) {
+                batch.output[i] = bitcoin.uncompressPublicKey(batch.records[i]);
+            });
+        }, options.threads);
+    } else {
+        // derive: parse, multiply the whole batch with the base table, encode
+        pipeline.addStage([&bitcoin](Batch& batch) {
+            batch.keys.resize(batch.records.size());
+            each(batch, [&](std::size_t i) {
+                batch.keys[i].set_str(bitcoin.convertToPrivateHex(batch.records[i]), 16);
+            });
+        }, options.threads);
+
+        const BaseTable& table = table_;
+        pipeline.addStage([&table](Batch& batch) {
+            std::vector<mpz_class> keys;
+            for (std::size_t i = 0; i < batch.keys.size(); i++) {
+                if (batch.errors[i].empty()) {
+                    keys.push_back(batch.keys[i]);
+                }
+            }
+
+            std::vector<Point> points = table.multiply(keys);
+            batch.points.resize(batch.keys.size());
+            for (std::size_t i = 0, t = 0; i < batch.keys.size(); i++) {
+                if (batch.errors[i].empty()) {
+                    batch.points[i] = points[t++];
+                }
+            }
+        }, options.threads);
+
+        bool compressed = options.compressed, address = options.address;
+        pipeline.addStage([&bitcoin, compressed, address](Batch& batch) {
+            each(batch, [&](std::size_t i) {
+                batch.output[i] = address ? bitcoin.pointToAddress(batch.points[i], compressed)
+                    : bitcoin.pointToPublicKey(batch.points[i], compressed);
+            });
+        }, options.threads);
+    }
+
+    bool succeeded = true;
+    std::string buffer;
+    pipeline.run(source, [&](Batch& batch) {
+        buffer.clear();
+        for (std::size_t i = 0; i < batch.errors.size(); i++) {
+            // Blank and failed records leave an empty line so the output stays
+            // aligned with the input lines
+            if (!batch.errors[i].empty() && !batch.blank[i]) {
+                err_ << "elliptic: line " << batch.lines[i] << ": " << batch.errors[i] << "\n";
+                succeeded = false;
+            } else if (batch.errors[i].empty()) {
+                buffer += batch.output[i];
+            }
+
+            buffer += '\n';
+        }
+
+        out_.write(buffer.data(), buffer.size());
+    });
+
+    out_.flush();
+    if (!out_) {
+        throw std::runtime_error("Unable to write output");
+    }
+
+    return succeeded;
+}
+
+/**
+ * Runs a Server on the socket until SIGINT or SIGTERM, then prints its
+ * counters.
+ */
+void Elliptic::Cli::serve(const Options& options) {
+    Server::Options serverOptions;
+    serverOptions.path = options.socket;
+    serverOptions.maxBatch = static_cast<std::size_t>(options.batch);
+    serverOptions.deadline = std::chrono::microseconds(options.deadline);
+    serverOptions.workers = options.threads;
+    Server server(serverOptions);
+
+    struct sigaction action = {}, previousInt, previousTerm;
+    action.sa_handler = interrupt;
+    sigemptyset(&action.sa_mask);
+    serving = &server;
+    sigaction(SIGINT, &action, &previousInt);
+    sigaction(SIGTERM, &action, &previousTerm);
+
+    try {
+        server.run();
+    } catch (...) {
+        serving = nullptr;
+        sigaction(SIGINT, &previousInt, nullptr);
+        sigaction(SIGTERM, &previousTerm, nullptr);
+        throw;
+    }
+
+    serving = nullptr;
+    sigaction(SIGINT, &previousInt, nullptr);
+    sigaction(SIGTERM, &previousTerm, nullptr);
+
+    Server::Stats stats = server.stats();
+    out_ << "requests " << stats.requests << " batches " << stats.batches << " errors " << stats.errors
+        << " p50 " << stats.p50 / 1000 << "us p99 " << stats.p99 / 1000 << "us\n";
+}
+
+/**
+ * Sends `count` requests over `connections` connections and prints the
+ * throughput and latency seen by the clients and by the server. Returns
+ * false if any request failed.
+ */
+bool Elliptic::Cli::load(const Options& options) {
+    ServerClient::Report report = ServerClient::load(options.socket,
+            static_cast<unsigned>(options.connections), options.count,
+            static_cast<std::size_t>(options.depth), options.address ? Server::ADDRESS : Server::PUBLIC_KEY);
+    Server::Stats stats = ServerClient(options.socket).stats();
+
+    out_ << "requests " << report.requests << " errors " << report.errors << " seconds " << report.seconds
+        << " throughput " << static_cast<unsigned long long>(report.requests / std::max(report.seconds, 1e-9))
+        << "/s p50 " << report.p50 / 1000 << "us p99 " << report.p99 / 1000 << "us\n"
+        << "server requests " << stats.requests << " batches " << stats.batches << " p50 " << stats.p50 / 1000
+        << "us p99 " << stats.p99 / 1000 << "us\n";
+    return report.errors == 0;
+}
@@ -1,19 +1,251 @@
 #include "curve.h"
 
-#include <algorithm> // std::reverse
-#include <cmath>     // std::pow
 #include <stdexcept> // std::invalid_argument
 
-Elliptic::Curve::Curve(int a, int b, mpz_class prime) {
+#include "instrument.h"
+#include "msm.h"
+
+namespace {
+
+    /**
+     * Affine point in mpz_t registers, see Registers.
+     */
+    struct Register {
+        mpz_t x, y;
+        bool zero;
+    };
+
+    /**
+     * Working registers of the mpz_class fallback, one set per thread. Their
+     * limbs are sized for the widest prime seen and then reused, so additions,
+     * doublings and whole scalar multiplications keep their temporaries off the
+     * heap; only the returned points allocate.
+     */
+    struct Scratch {
+        Register p, q;
+        mpz_t lambda, t, u, product;
+        mpz_t prime, exponent; // exponent = prime - 2 for Fermat inversion
+        std::size_t bits;
+
+        // Batches for Curve::addBatch, kept between calls up to RETAINED entries
+        static const std::size_t RETAINED = 4096;
+        std::vector<std::size_t> batch;
+        std::vector<mpz_class> denoms, prefix;
+
+        Scratch() : bits(0) {
+            mpz_inits(p.x, p.y, q.x, q.y, lambda, t, u, product, prime, exponent, nullptr);
+        }
+
+        ~Scratch() {
+            mpz_clears(p.x, p.y, q.x, q.y, lambda, t, u, product, prime, exponent, nullptr);
+        }
+
+        /**
+         * Releases what a batch larger than RETAINED left behind, so one big
+         * batch does not pin its memory for the lifetime of the thread.
+         */
+        void trim() {
+            if (denoms.size() > RETAINED) {
+                denoms.resize(RETAINED);
+                denoms.shrink_to_fit();
+                prefix.resize(RETAINED);
+                prefix.shrink_to_fit();
+            }
+
+            if (batch.capacity() > RETAINED) {
+                batch.clear();
+                batch.shrink_to_fit();
+            }
+        }
+    };
+
+    /**
+     * Affine group law on the calling thread's Scratch for the curve
+     * y^2 = x^3 + ax + b (mod prime).
+     */
+    class Registers {
+    public:
+        Registers(const mpz_class& a, const mpz_class& prime);
+
+        Register& p() { return scratch_.p; }
+        Register& q() { return scratch_.q; }
+        Scratch& scratch() { return scratch_; }
+
+        void load(Register& r, const Elliptic::Point& op);
+        Elliptic::Point toPoint(const Register& r) const;
+
+        void invert(mpz_ptr r, mpz_srcptr op);
+        void add(Register& p, const Register& q);
+        void twice(Register& p);
+    private:
+        Scratch& scratch_;
+        mpz_srcptr a_, prime_;
+
+        static Scratch& local() {
+            thread_local Scratch scratch;
+            return scratch;
+        }
+    };
+
+    Registers::Registers(const mpz_class& a, const mpz_class& prime)
+            : scratch_(local()), a_(a.get_mpz_t()), prime_(prime.get_mpz_t()) {
+        Scratch& s = scratch_;
+        if (mpz_cmp(s.prime, prime_) == 0) {
+            return;
+        }
+
+        // Products of two coordinates plus a word of slack
+        std::size_t bits = 2*mpz_sizeinbase(prime_, 2) + 64;
+        if (bits > s.bits) {
+            for (mpz_ptr r : { s.p.x, s.p.y, s.q.x, s.q.y, s.lambda, s.t, s.u, s.product }) {
+                mpz_realloc2(r, bits);
+            }
+            s.bits = bits;
+        }
+
+        mpz_set(s.prime, prime_);
+        mpz_sub_ui(s.exponent, prime_, 2);
+    }
+
+    void Registers::load(Register& r, const Elliptic::Point& op) {
+        r.zero = op.isZero();
+        mpz_set(r.x, op.getX().get_mpz_t());
+        mpz_set(r.y, op.getY().get_mpz_t());
+    }
+
+    Elliptic::Point Registers::toPoint(const Register& r) const {
+        return r.zero ? Elliptic::Point() : Elliptic::Point(mpz_class(r.x), mpz_class(r.y));
+    }
+
+    /**
+     * Inverse mod p using Fermat's little theorem, as Curve::inverse.
+     */
+    void Registers::invert(mpz_ptr r, mpz_srcptr op) {
+        if (mpz_divisible_p(op, prime_) != 0) {
+            throw std::invalid_argument("Inverse does not exist");
+        }
+
+        ELLIPTIC_COUNT(INVERSIONS);
+
+        mpz_powm_sec(r, op, scratch_.exponent, prime_);
+    }
+
+    void Registers::add(Register& p, const Register& q) {
+        Scratch& s = scratch_;
+        if (q.zero) {
+            return;
+        }
+
+        if (p.zero) {
+            mpz_set(p.x, q.x);
+            mpz_set(p.y, q.y);
+            p.zero = false;
+            return;
+        }
+
+        if (mpz_cmp(p.x, q.x) == 0) {
+            // p = q doubles, p = -q sums to the identity
+            if (mpz_cmp(p.y, q.y) == 0) {
+                twice(p);
+            } else {
+                p.zero = true;
+            }
+            return;
+        }
+
+        ELLIPTIC_COUNT_N(FIELD_MULTIPLICATIONS, 3);
+
+        // lambda = (py - qy) / (px - qx)
+        mpz_sub(s.u, p.x, q.x);
+        invert(s.u, s.u);
+        mpz_sub(s.t, p.y, q.y);
+        mpz_mul(s.lambda, s.t, s.u);
+        mpz_mod(s.lambda, s.lambda, prime_);
+
+        mpz_mul(s.t, s.lambda, s.lambda);
+        mpz_sub(s.t, s.t, p.x);
+        mpz_sub(s.t, s.t, q.x);
+        mpz_mod(s.t, s.t, prime_);
+
+        mpz_sub(s.u, p.x, s.t);
+        mpz_mul(s.u, s.u, s.lambda);
+        mpz_sub(s.u, s.u, p.y);
+        mpz_mod(p.y, s.u, prime_);
+        mpz_swap(p.x, s.t);
+    }
+
+    void Registers::twice(Register& p) {
+        Scratch& s = scratch_;
+        if (p.zero) {
+            return;
+        }
+
+        // Points of order two, 2p = 0
+        if (mpz_sgn(p.y) == 0) {
+            p.zero = true;
+            return;
+        }
+
+        ELLIPTIC_COUNT_N(FIELD_MULTIPLICATIONS, 4);
+
+        // lambda = (3*x^2 + a) / (2*y)
+        mpz_mul_2exp(s.u, p.y, 1);
+        invert(s.u, s.u);
+        mpz_mul(s.t, p.x, p.x);
+        mpz_mul_ui(s.t, s.t, 3);
+        mpz_add(s.t, s.t, a_);
+        mpz_mul(s.lambda, s.t, s.u);
+        mpz_mod(s.lambda, s.lambda, prime_);
+
+        mpz_mul(s.t, s.lambda, s.lambda);
+        mpz_submul_ui(s.t, p.x, 2);
+        mpz_mod(s.t, s.t, prime_);
+
+        mpz_sub(s.u, p.x, s.t);
+        mpz_mul(s.u, s.u, s.lambda);
+        mpz_sub(s.u, s.u, p.y);
+        mpz_mod(p.y, s.u, prime_);
+        mpz_swap(p.x, s.t);
+    }
+
+    /**
+     * Affine points for Msm on the mpz_class fallback.
+     */
+    class AffineGroup {
+    public:
+        typedef Elliptic::Point Element;
+        typedef Elliptic::Point Base;
+
+        AffineGroup(const Elliptic::Curve& curve) : curve_(curve) {}
+
+        Element identity() const { return Element(); }
+        Base fromPoint(const Elliptic::Point& p) const { return p; }
+        Element fromBase(const Base& p) const { return p; }
+        Elliptic::Point toPoint(const Element& p) const { return p; }
+        void add(Element& p, const Element& q) const { p = curve_.add(p, q); }
+        void twice(Element& p) const { p = curve_.multiply(p); }
+    private:
+        const Elliptic::Curve& curve_;
+    };
+
+}
+
+Elliptic::Curve::Curve(mpz_class a, mpz_class b, mpz_class prime) {
     this->a_ = a;
     this->b_ = b;
     this->prime_ = prime;
 
     // \delta = 4a^3 + 27b^2
-    double discriminant = 4*std::pow(a_, 3) + 27*std::pow(b_, 2);
-    if (std::abs(discriminant) < 1e-12) {
+    mpz_class discriminant = 4*a_*a_*a_ + 27*b_*b_;
+    if (sgn(prime_) > 0) {
+        mpz_mod(discriminant.get_mpz_t(), discriminant.get_mpz_t(), prime_.get_mpz_t());
+    }
+
+    if (sgn(discriminant) == 0) {
         throw std::invalid_argument("Discriminant must be non-zero");
     }
+
+    arithmetic_ = Arithmetic::create(a_, b_, prime_);
 }
 
 /**
@@ -39,14 +271,24 @@ mpz_class Elliptic::Curve::getOrder() const {
  * Checks if the given point is on the curve, y^2 = x^3 + ax + b (mod p).
  */
 bool Elliptic::Curve::hasPoint(const Point& p) const {
-    mpz_class left, right;
-    mpz_powm_ui(left.get_mpz_t(), p.getY().get_mpz_t(), 2, prime_.get_mpz_t());
+    if (arithmetic_) {
+        return arithmetic_->hasPoint(p);
+    }
+
+    ELLIPTIC_COUNT_N(FIELD_MULTIPLICATIONS, 3);
+
+    Registers registers(a_, prime_);
+    mpz_ptr left = registers.scratch().t, right = registers.scratch().u;
+    mpz_powm_ui(left, p.getY().get_mpz_t(), 2, prime_.get_mpz_t());
 
-    mpz_powm_ui(right.get_mpz_t(), p.getX().get_mpz_t(), 3, prime_.get_mpz_t());
-    right += a_*p.getX() + b_;
-    mpz_mod(right.get_mpz_t(), right.get_mpz_t(), prime_.get_mpz_t());
+    // (x^2 + a)x + b
+    mpz_mul(right, p.getX().get_mpz_t(), p.getX().get_mpz_t());
+    mpz_add(right, right, a_.get_mpz_t());
+    mpz_mul(right, right, p.getX().get_mpz_t());
+    mpz_add(right, right, b_.get_mpz_t());
+    mpz_mod(right, right, prime_.get_mpz_t());
 
-    return cmp(left, right) == 0;
+    return mpz_cmp(left, right) == 0;
 }
 
 /**
@@ -62,7 +304,9 @@ Elliptic::Point Elliptic::Curve::negatePoint(const Point &p) const {
 /**
  * Adds two Points on the curve, y^2 = x^3 + ax + b (mod p).
  */
-Elliptic::Point Elliptic::Curve::add(Point p, Point q) const {
+Elliptic::Point Elliptic::Curve::add(const Point& p, const Point& q) const {
+    ELLIPTIC_COUNT(ADDITIONS);
+
     // p + 0 = p
     if (q.isZero()) {
         return p;
@@ -73,82 +317,193 @@ Elliptic::Point Elliptic::Curve::add(Point p, Point q) const {
         return q;
     }
 
-    if (cmp(p.getX(), q.getX()) == 0) {
-        // p = q
-        if (cmp(p.getY(), q.getY()) == 0) {
-            return multiply(p);
+    if (arithmetic_) {
+        return arithmetic_->add(p, q);
+    }
+
+    Registers registers(a_, prime_);
+    registers.load(registers.p(), p);
+    registers.load(registers.q(), q);
+    registers.add(registers.p(), registers.q());
+    return registers.toPoint(registers.p());
+}
+
+/**
+ * Adds q to every point in place, sharing a single inversion between all of
+ * the additions (Montgomery's trick).
+ */
+void Elliptic::Curve::add(std::vector<Point>& points, const Point& q) const {
+    if (q.isZero()) {
+        return;
+    }
+
+    if (arithmetic_) {
+        ELLIPTIC_COUNT_N(ADDITIONS, points.size());
+        arithmetic_->add(points, &q, 0);
+        return;
+    }
+
+    addBatch(points, [&q](std::size_t) -> const Point& { return q; });
+}
+
+/**
+ * Adds q_i to p_i for every i in place, sharing a single inversion between all
+ * of the additions.
+ */
+void Elliptic::Curve::add(std::vector<Point>& points, const std::vector<Point>& q) const {
+    if (points.size() != q.size()) {
+        throw std::invalid_argument("Batch addition requires the same number of points");
+    }
+
+    if (arithmetic_) {
+        ELLIPTIC_COUNT_N(ADDITIONS, points.size());
+        arithmetic_->add(points, q.data(), 1);
+        return;
+    }
+
+    addBatch(points, [&q](std::size_t i) -> const Point& { return q[i]; });
+}
+
+/**
+ * Batched affine addition p_i = p_i + q(i) with Montgomery's trick: the
+ * denominators are multiplied together, inverted once and the individual
+ * inverses recovered with two multiplications each. Additions that need
+ * doubling or involve the identity fall back to `add`.
+ */
+template <class Q>
+void Elliptic::Curve::addBatch(std::vector<Point>& points, Q q) const {
+    Registers registers(a_, prime_);
+    Scratch& s = registers.scratch();
+    std::vector<std::size_t>& batch = s.batch;
+    batch.clear();
+
+    // prefix[t] = denoms[0] * ... * denoms[t-1]
+    mpz_set_ui(s.product, 1);
+    for (std::size_t i = 0; i < points.size(); i++) {
+        const Point& p = points[i];
+        if (p.isZero() || q(i).isZero() || cmp(p.getX(), q(i).getX()) == 0) {
+            points[i] = add(p, q(i));
+            continue;
+        }
+
+        std::size_t t = batch.size();
+        if (t == s.denoms.size()) {
+            s.denoms.emplace_back();
+            s.prefix.emplace_back();
         }
 
-        // p = -q
-        return Point();
+        mpz_class& denom = s.denoms[t];
+        mpz_sub(denom.get_mpz_t(), p.getX().get_mpz_t(), q(i).getX().get_mpz_t());
+        mpz_mod(denom.get_mpz_t(), denom.get_mpz_t(), prime_.get_mpz_t());
+
+        batch.push_back(i);
+        mpz_set(s.prefix[t].get_mpz_t(), s.product);
+        mpz_mul(s.product, s.product, denom.get_mpz_t());
+        mpz_mod(s.product, s.product, prime_.get_mpz_t());
     }
 
-    mpz_class num = p.getY() - q.getY();
-    mpz_class denom = p.getX() - q.getX();
-    mpz_class lambda = num*inverse(denom);
+    if (batch.empty()) {
+        return;
+    }
 
-    mpz_class x;
-    mpz_powm_ui(x.get_mpz_t(), lambda.get_mpz_t(), 2, prime_.get_mpz_t());
-    x -= p.getX() + q.getX();
-    mpz_mod(x.get_mpz_t(), x.get_mpz_t(), prime_.get_mpz_t());
+    ELLIPTIC_COUNT_N(ADDITIONS, batch.size());
+    ELLIPTIC_COUNT_N(FIELD_MULTIPLICATIONS, 6*batch.size()); // One for the prefix, five to unwind
 
-    mpz_class y = p.getX() - x;
-    y *= lambda;
-    y -= p.getY();
-    mpz_mod(y.get_mpz_t(), y.get_mpz_t(), prime_.get_mpz_t());
+    mpz_ptr inv = s.product, lambda = s.lambda, x = s.t, y = s.u;
+    registers.invert(inv, inv);
+    for (std::size_t t = batch.size(); t-- > 0;) {
+        const Point& p = points[batch[t]];
+        const Point& r = q(batch[t]);
 
-    return Point(x, y);
+        // inv = (denoms[0] * ... * denoms[t])^-1
+        mpz_mul(lambda, inv, s.prefix[t].get_mpz_t());
+        mpz_mul(inv, inv, s.denoms[t].get_mpz_t());
+        mpz_mod(inv, inv, prime_.get_mpz_t());
+
+        mpz_sub(y, p.getY().get_mpz_t(), r.getY().get_mpz_t());
+        mpz_mul(lambda, lambda, y);
+        mpz_mod(lambda, lambda, prime_.get_mpz_t());
+
+        mpz_mul(x, lambda, lambda);
+        mpz_sub(x, x, p.getX().get_mpz_t());
+        mpz_sub(x, x, r.getX().get_mpz_t());
+        mpz_mod(x, x, prime_.get_mpz_t());
+
+        mpz_sub(y, p.getX().get_mpz_t(), x);
+        mpz_mul(y, y, lambda);
+        mpz_sub(y, y, p.getY().get_mpz_t());
+        mpz_mod(y, y, prime_.get_mpz_t());
+
+        points[batch[t]] = Point(mpz_class(x), mpz_class(y));
+    }
+
+    s.trim();
 }
 
 /**
  * Doubles a Point on the curve, y^2 = x^3 + ax + b (mod p).
  */
-Elliptic::Point Elliptic::Curve::multiply(Point p) const {
+Elliptic::Point Elliptic::Curve::multiply(const Point& p) const {
+    ELLIPTIC_COUNT(DOUBLINGS);
+
     if (p.isZero()) {
         return p;
     }
 
-    mpz_class squared;
-    mpz_powm_ui(squared.get_mpz_t(), p.getX().get_mpz_t(), 2, prime_.get_mpz_t());
-
-    // lambda = (3*x^2 + a) / (2*y)
-    mpz_class lambda = (3*squared + a_)*inverse(2*p.getY());
-
-    mpz_class x;
-    mpz_powm_ui(x.get_mpz_t(), lambda.get_mpz_t(), 2, prime_.get_mpz_t());
-    x -= 2*p.getX();
-    mpz_mod(x.get_mpz_t(), x.get_mpz_t(), prime_.get_mpz_t());
-
-    mpz_class y = p.getX() - x;
-    y *= lambda;
-    y -= p.getY();
-    mpz_mod(y.get_mpz_t(), y.get_mpz_t(), prime_.get_mpz_t());
+    if (arithmetic_) {
+        return arithmetic_->twice(p);
+    }
 
-    return Point(x, y);
+    Registers registers(a_, prime_);
+    registers.load(registers.p(), p);
+    registers.twice(registers.p());
+    return registers.toPoint(registers.p());
 }
 
 /**
  * Computes q = np where n is a natural number greater than zero and p is point
  * on the curve, y^2 = x^3 + ax + b (mod p).
  */
-Elliptic::Point Elliptic::Curve::multiply(Point p, mpz_class n) const {
+Elliptic::Point Elliptic::Curve::multiply(const Point& p, const mpz_class& n) const {
     if (sgn(n) <= 0) {
         throw std::invalid_argument("n must be greater than 0");
     }
 
-    std::string binary = n.get_str(2);
-    std::reverse(binary.begin(), binary.end());
+    ELLIPTIC_COUNT(SCALAR_MULTIPLICATIONS);
+
+    if (arithmetic_) {
+        return arithmetic_->multiply(p, n);
+    }
 
-    Point q;
-    for (char bit : binary) {
-        if (bit == '1') {
-            q = add(q, p);
+    // Left-to-right double-and-add, entirely in registers
+    Registers registers(a_, prime_);
+    Register& q = registers.p();
+    registers.load(q, p);
+    registers.load(registers.q(), p);
+    for (std::size_t i = mpz_sizeinbase(n.get_mpz_t(), 2) - 1; i-- > 0;) {
+        registers.twice(q);
+        if (mpz_tstbit(n.get_mpz_t(), i)) {
+            registers.add(q, registers.q());
         }
+    }
+
+    return registers.toPoint(q);
+}
+
+/**
+ * Computes the multi-scalar multiplication k_0 p_0 + ... + k_{n-1} p_{n-1}
+ * for scalars k_i >= 0, see Msm::multiply. Large inputs are spread over up
+ * to `workers` threads.
+ */
+Elliptic::Point Elliptic::Curve::multiply(const std::vector<Point>& points,
+        const std::vector<mpz_class>& scalars, unsigned workers) const {
+    ELLIPTIC_COUNT(SCALAR_MULTIPLICATIONS);
 
-        p = multiply(p);
+    if (arithmetic_) {
+        return arithmetic_->multiply(points, scalars, workers);
     }
 
-    return q;
+    return Msm::multiply(AffineGroup(*this), points, scalars, workers);
 }
 
 /**
@@ -159,6 +514,8 @@ mpz_class Elliptic::Curve::inverse(const mpz_class& op) const {
         throw std::invalid_argument("Inverse does not exist");
     }
 
+    ELLIPTIC_COUNT(INVERSIONS);
+
     // Fermat's Little Theorem
     mpz_class inv, exp = prime_ - 2;
     mpz_powm_sec(inv.get_mpz_t(), op.get_mpz_t(), exp.get_mpz_t(), prime_.get_mpz_t());
@@ -179,3 +536,14 @@ mpz_class Elliptic::Curve::squareRoot(const mpz_class& op) const {
     return sqr;
 }
 
+/**
+ * Converts a hexadecimal string to an arbitrary precision data type.
+ */
+mpz_class Elliptic::Curve::convertHex(const std::string& hexString) {
+    mpz_class value;
+    if (value.set_str(hexString, 16) != 0) {
+        throw std::invalid_argument("Unable to convert hexadecimal string");
+    }
+
+    return value;
+}
@@ -1,34 +1,46 @@
 #include "hash.h"
 
 #include <cctype>    // std::isxdigit
-#include <iomanip>   // std::setfill, std::setw
-#include <iostream>  // std::hex
-#include <sstream>   // std::stringstream
 #include <stdexcept> // std::invalid_argument
 
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
 #include <openssl/sha.h>
-#include <openssl/rand.h>
 #include <openssl/ripemd.h>
 
+#include "instrument.h"
+#include "random.h"
+
 /**
  * Generates the SHA256 hash of a string using the OpenSSL library.
  */
 std::string Elliptic::Hash::sha256(const std::string& input) {
     std::vector<std::uint8_t> data = hexToByte(input);
     std::uint8_t output[SHA256_DIGEST_LENGTH];
+    sha256(data.data(), data.size(), output);
+
+    return byteToHex(output, SHA256_DIGEST_LENGTH);
+}
+
+/**
+ * SHA256 of raw bytes into a 32-byte output buffer, skipping the hexadecimal
+ * conversions for callers hashing in a tight loop.
+ */
+void Elliptic::Hash::sha256(const std::uint8_t* input, std::size_t length, std::uint8_t* output) {
+    ELLIPTIC_COUNT(HASHES);
 
     SHA256_CTX ctx;
     SHA256_Init(&ctx);
-    SHA256_Update(&ctx, &data[0], data.size());
+    SHA256_Update(&ctx, input, length);
     SHA256_Final(output, &ctx);
-
-    return byteToHex(output, SHA256_DIGEST_LENGTH);
 }
 
 /**
  * Generates the RIPEMD160 hash of a string using the OpenSSL library.
  */
 std::string Elliptic::Hash::ripemd160(const std::string& input) {
+    ELLIPTIC_COUNT(HASHES);
+
     std::vector<std::uint8_t> data = hexToByte(input);
     std::uint8_t output[RIPEMD160_DIGEST_LENGTH];
 
@@ -41,15 +53,32 @@ std::string Elliptic::Hash::ripemd160(const std::string& input) {
 }
 
 /**
- * Generates a hexadecimal string of random bytes using the OpenSSL library.
+ * Generates the HMAC-SHA512 of a hexadecimal string with a hexadecimal key
+ * using the OpenSSL library.
  */
-std::string Elliptic::Hash::getRandom(std::size_t bytes) {
-    std::uint8_t buf[bytes];
-    if (RAND_bytes(buf, bytes) != 1) {
-        throw std::runtime_error("OpenSSL unable to generate random bytes");
+std::string Elliptic::Hash::hmacSha512(const std::string& key, const std::string& input) {
+    ELLIPTIC_COUNT(HASHES);
+
+    std::vector<std::uint8_t> k = hexToByte(key);
+    std::vector<std::uint8_t> data = hexToByte(input);
+    std::uint8_t output[SHA512_DIGEST_LENGTH];
+    unsigned int length = 0;
+
+    if (HMAC(EVP_sha512(), k.data(), k.size(), data.data(), data.size(), output, &length) == NULL) {
+        throw std::runtime_error("OpenSSL unable to compute HMAC-SHA512");
     }
 
-    return byteToHex(buf, bytes);
+    return byteToHex(output, length);
+}
+
+/**
+ * Generates a hexadecimal string of cryptographically secure random bytes.
+ */
+std::string Elliptic::Hash::getRandom(std::size_t bytes) {
+    std::vector<std::uint8_t> buf(bytes);
+    Random::bytes(buf.data(), bytes);
+
+    return byteToHex(buf.data(), bytes);
 }
 
 /**
@@ -78,12 +107,15 @@ std::vector<std::uint8_t> Elliptic::Hash::hexToByte(const std::string& input) {
 /**
  * Converts a uint8_t (byte) array pointer to a hexadecimal string.
  */
-std::string Elliptic::Hash::byteToHex(std::uint8_t* input, std::size_t length) {
-    std::stringstream ss;
+std::string Elliptic::Hash::byteToHex(const std::uint8_t* input, std::size_t length) {
+    static const char DIGITS[] = "0123456789abcdef";
+
+    std::string output(2*length, '0');
     for (std::size_t i = 0; i < length; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << (int) input[i];
+        output[2*i] = DIGITS[input[i] >> 4];
+        output[2*i + 1] = DIGITS[input[i] & 0xF];
     }
 
-    return ss.str();
+    return output;
 }
 
@@ -0,0 +1,104 @@
+#include "instrument.h"
+
+#include <gmp.h>
+
+const char* const Elliptic::Instrument::COUNTER_NAMES[] = {
+    "inversions", "scalar_multiplications", "field_multiplications", "additions",
+    "doublings", "hashes", "encodes", "allocated_bytes"
+};
+
+const char* const Elliptic::Instrument::STAGE_NAMES[] = {
+    "generate", "convert", "public_key", "address", "wif", "render",
+    "baby_steps", "giant_steps"
+};
+
+#ifdef ELLIPTIC_INSTRUMENT
+
+std::atomic<std::uint64_t> Elliptic::Instrument::counters[COUNTERS];
+
+namespace {
+
+    std::atomic<std::uint64_t> calls[Elliptic::Instrument::STAGES];
+    std::atomic<std::uint64_t> nanoseconds[Elliptic::Instrument::STAGES];
+
+    void* (*nextAllocate)(std::size_t);
+    void* (*nextReallocate)(void*, std::size_t, std::size_t);
+    void (*nextFree)(void*, std::size_t);
+
+    void* countAllocate(std::size_t size) {
+        Elliptic::Instrument::count(Elliptic::Instrument::ALLOCATED_BYTES, size);
+        return nextAllocate(size);
+    }
+
+    void* countReallocate(void* ptr, std::size_t oldSize, std::size_t newSize) {
+        if (newSize > oldSize) {
+            Elliptic::Instrument::count(Elliptic::Instrument::ALLOCATED_BYTES,
+                newSize - oldSize);
+        }
+
+        return nextReallocate(ptr, oldSize, newSize);
+    }
+
+    /**
+     * Chains the GMP memory functions at static initialization so that bytes
+     * allocated for integers are counted without replacing any allocator
+     * installed later on top of this one.
+     */
+    struct GmpHook {
+        GmpHook() {
+            mp_get_memory_functions(&nextAllocate, &nextReallocate, &nextFree);
+            mp_set_memory_functions(countAllocate, countReallocate, nextFree);
+        }
+    } gmpHook;
+
+}
+
+Elliptic::Instrument::Timer::~Timer() {
+    auto elapsed = std::chrono::steady_clock::now() - start_;
+    calls[stage_].fetch_add(1, std::memory_order_relaxed);
+    nanoseconds[stage_].fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        elapsed).count(), std::memory_order_relaxed);
+}
+
+bool Elliptic::Instrument::enabled() {
+    return true;
+}
+
+Elliptic::Instrument::Snapshot Elliptic::Instrument::snapshot() {
+    Snapshot s;
+    for (int i = 0; i < COUNTERS; i++) {
+        s.counters[i] = counters[i].load(std::memory_order_relaxed);
+    }
+
+    for (int i = 0; i < STAGES; i++) {
+        s.calls[i] = calls[i].load(std::memory_order_relaxed);
+        s.nanoseconds[i] = nanoseconds[i].load(std::memory_order_relaxed);
+    }
+
+    return s;
+}
+
+void Elliptic::Instrument::reset() {
+    for (int i = 0; i < COUNTERS; i++) {
+        counters[i].store(0, std::memory_order_relaxed);
+    }
+
+    for (int i = 0; i < STAGES; i++) {
+        calls[i].store(0, std::memory_order_relaxed);
+        nanoseconds[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+#else
+
+bool Elliptic::Instrument::enabled() {
+    return false;
+}
+
+Elliptic::Instrument::Snapshot Elliptic::Instrument::snapshot() {
+    return Snapshot();
+}
+
+void Elliptic::Instrument::reset() {}
+
+#endif
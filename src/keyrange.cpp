@@ -0,0 +1,79 @@
+#include "keyrange.h"
+
+#include <algorithm> // std::max, std::min
+#include <stdexcept> // std::invalid_argument
+
+const std::size_t Elliptic::KeyRange::BATCH = 256;
+
+Elliptic::KeyRange::KeyRange(const Curve& curve, const Point& G, const mpz_class& first,
+        std::uint64_t count, const mpz_class& stride)
+    : curve_(curve), G_(G), first_(first), stride_(stride), count_(count), position_(0) {
+    if (sgn(first) < 0 || sgn(stride) <= 0) {
+        throw std::invalid_argument("Key range requires a non-negative first key and a positive stride");
+    }
+}
+
+/**
+ * Replaces `points` with the points of the next keys, up to BATCH of them,
+ * and returns false once the range is exhausted. points[i] is the point of
+ * key(p + i), where p is position() before the call.
+ */
+bool Elliptic::KeyRange::next(std::vector<Point>& points) {
+    if (position_ >= count_) {
+        return false;
+    }
+
+    if (lanes_.empty()) {
+        start();
+    } else {
+        // Lanes past the end of the range are not advanced
+        std::uint64_t remaining = count_ - position_;
+        if (remaining < lanes_.size()) {
+            lanes_.resize(static_cast<std::size_t>(remaining));
+        }
+
+        curve_.add(lanes_, step_);
+    }
+
+    points = lanes_;
+    position_ += lanes_.size();
+    return true;
+}
+
+/**
+ * Splits the whole range into up to `parts` ranges of consecutive keys,
+ * positioned at their start, with sizes differing by at most one.
+ */
+std::vector<Elliptic::KeyRange> Elliptic::KeyRange::split(unsigned parts) const {
+    std::vector<KeyRange> ranges;
+    parts = static_cast<unsigned>(std::min<std::uint64_t>(std::max(1u, parts), std::max<std::uint64_t>(count_, 1)));
+
+    std::uint64_t begin = 0;
+    for (unsigned i = 0; i < parts; i++) {
+        std::uint64_t size = count_ / parts + (i < count_ % parts ? 1 : 0);
+        ranges.emplace_back(curve_, G_, key(begin), size, stride_);
+        begin += size;
+    }
+
+    return ranges;
+}
+
+/**
+ * Computes the lanes from the first key of the range with one scalar
+ * multiplication and a batched addition per doubling of the lane count.
+ */
+void Elliptic::KeyRange::start() {
+    std::size_t lanes = static_cast<std::size_t>(std::min<std::uint64_t>(BATCH, count_));
+    Point shift = curve_.multiply(G_, stride_); // lanes_.size() stride G
+
+    lanes_.reserve(lanes);
+    lanes_.push_back(sgn(first_) == 0 ? Point() : curve_.multiply(G_, first_));
+    while (lanes_.size() < lanes) {
+        std::vector<Point> shifted(lanes_.begin(), lanes_.begin() + std::min(lanes_.size(), lanes - lanes_.size()));
+        curve_.add(shifted, shift);
+        lanes_.insert(lanes_.end(), shifted.begin(), shifted.end());
+        shift = curve_.multiply(shift);
+    }
+
+    step_ = curve_.multiply(G_, stride_*lanes);
+}
@@ -1,15 +1,22 @@
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include "bitcoin.h"
+#include "cli.h"
 
 using namespace Elliptic;
 
-int main() {
-    Bitcoin bitcoin;
+int main(int argc, char* argv[]) {
+    if (argc == 1) {
+        Bitcoin bitcoin;
 
-    // Generate a new uncompressed paper wallet
-    bitcoin.paperWallet(bitcoin.generatePrivateHex(), false);
+        // Generate a new uncompressed paper wallet
+        bitcoin.paperWallet(bitcoin.generatePrivateHex(), false);
 
-    return 0;
-}
+        return 0;
+    }
 
+    std::ios::sync_with_stdio(false);
+    return Cli(std::cin, std::cout, std::cerr).run(std::vector<std::string>(argv + 1, argv + argc));
+}
@@ -0,0 +1,124 @@
+#include "pdf.h"
+
+#include <cstdio>    // std::snprintf
+#include <fstream>   // std::ofstream
+#include <sstream>   // std::ostringstream
+#include <stdexcept> // std::runtime_error
+
+const double Elliptic::Pdf::LETTER_WIDTH = 612;
+const double Elliptic::Pdf::LETTER_HEIGHT = 792;
+
+namespace {
+
+    std::string number(double value) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.2f", value);
+        return buffer;
+    }
+
+}
+
+/**
+ * Writes the document: catalog, page tree, fonts, then a page object and a
+ * content stream per page, followed by the cross-reference table.
+ */
+void Elliptic::Pdf::save(const std::string& path) const {
+    std::ostringstream out;
+    std::vector<std::size_t> offsets;
+    auto object = [&out, &offsets](const std::string& body) {
+        offsets.push_back(out.tellp());
+        out << offsets.size() << " 0 obj\n" << body << "\nendobj\n";
+    };
+
+    out << "%PDF-1.4\n";
+
+    std::string kids;
+    for (std::size_t i = 0; i < pages_.size(); i++) {
+        kids += std::to_string(5 + 2*i) + " 0 R ";
+    }
+
+    object("<< /Type /Catalog /Pages 2 0 R >>");
+    object("<< /Type /Pages /Kids [" + kids + "] /Count " + std::to_string(pages_.size()) + " >>");
+    object("<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica /Encoding /WinAnsiEncoding >>");
+    object("<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica-Bold /Encoding /WinAnsiEncoding >>");
+
+    for (std::size_t i = 0; i < pages_.size(); i++) {
+        object("<< /Type /Page /Parent 2 0 R /MediaBox [0 0 " + number(width_) + " "
+            + number(height_) + "] /Resources << /Font << /F1 3 0 R /F2 4 0 R >> >> /Contents "
+            + std::to_string(6 + 2*i) + " 0 R >>");
+        object("<< /Length " + std::to_string(pages_[i].length()) + " >>\nstream\n"
+            + pages_[i] + "\nendstream");
+    }
+
+    std::size_t xref = out.tellp();
+    out << "xref\n0 " << offsets.size() + 1 << "\n0000000000 65535 f \n";
+    for (std::size_t offset : offsets) {
+        char entry[24];
+        std::snprintf(entry, sizeof(entry), "%010zu 00000 n \n", offset);
+        out << entry;
+    }
+
+    out << "trailer\n<< /Size " << offsets.size() + 1 << " /Root 1 0 R >>\nstartxref\n"
+        << xref << "\n%%EOF\n";
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << out.str();
+    if (!file) {
+        throw std::runtime_error("Unable to write " + path);
+    }
+}
+
+/**
+ * Content stream operators drawing a line of text with its baseline at (x, y).
+ */
+std::string Elliptic::Pdf::text(double x, double y, double size, const std::string& text,
+        bool bold) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '(' || c == ')' || c == '\\') {
+            escaped += '\\';
+        }
+
+        escaped += c;
+    }
+
+    return "BT /" + std::string(bold ? "F2 " : "F1 ") + number(size) + " Tf " + number(x)
+        + " " + number(y) + " Td (" + escaped + ") Tj ET\n";
+}
+
+/**
+ * Content stream operators stroking a rectangle outline.
+ */
+std::string Elliptic::Pdf::rectangle(double x, double y, double width, double height) {
+    return number(x) + " " + number(y) + " " + number(width) + " " + number(height) + " re S\n";
+}
+
+/**
+ * Content stream operators filling the dark modules of a QR code in a square
+ * with its bottom left corner at (x, y). Horizontal runs are merged into one
+ * rectangle each.
+ */
+std::string Elliptic::Pdf::qrCode(const QRCode& code, double x, double y, double size) {
+    int n = code.getSize();
+    double module = size / n;
+
+    std::string ops;
+    for (int row = 0; row < n; row++) {
+        for (int column = 0; column < n;) {
+            if (!code.getModule(column, row)) {
+                column++;
+                continue;
+            }
+
+            int start = column;
+            while (column < n && code.getModule(column, row)) {
+                column++;
+            }
+
+            ops += number(x + start*module) + " " + number(y + (n - 1 - row)*module) + " "
+                + number((column - start)*module) + " " + number(module) + " re\n";
+        }
+    }
+
+    return ops + "f\n";
+}
@@ -0,0 +1,392 @@
+#include "qrcode.h"
+
+#include <algorithm> // std::max
+#include <climits>   // LONG_MAX
+#include <cstdlib>   // std::abs
+#include <stdexcept> // std::invalid_argument
+
+const int Elliptic::QRCode::MAX_VERSION = 10;
+
+// Error correction codewords per block and number of blocks for level M,
+// indexed by version
+const int Elliptic::QRCode::ECC_CODEWORDS[] = { -1, 10, 16, 26, 18, 24, 16, 18, 22, 22, 26 };
+const int Elliptic::QRCode::BLOCKS[] = { -1, 1, 1, 1, 2, 2, 4, 4, 4, 5, 5 };
+
+/**
+ * Encodes the text, choosing the mask pattern with the lowest penalty score.
+ */
+Elliptic::QRCode::QRCode(const std::string& text) {
+    // Mode indicator (4 bits), character count (8 or 16 bits) and the data
+    std::size_t capacity = 0;
+    for (version_ = 1; version_ <= MAX_VERSION; version_++) {
+        capacity = rawCodewords(version_) - ECC_CODEWORDS[version_]*BLOCKS[version_];
+        int countBits = version_ < 10 ? 8 : 16;
+        if (4 + countBits + 8*text.length() <= 8*capacity) {
+            break;
+        }
+    }
+
+    if (version_ > MAX_VERSION) {
+        throw std::invalid_argument("Text is too long for a QR code");
+    }
+
+    std::vector<bool> bits;
+    auto append = [&bits](unsigned long value, int length) {
+        for (int i = length - 1; i >= 0; i--) {
+            bits.push_back(((value >> i) & 1) != 0);
+        }
+    };
+
+    append(0x4, 4); // Byte mode
+    append(text.length(), version_ < 10 ? 8 : 16);
+    for (char c : text) {
+        append(static_cast<std::uint8_t>(c), 8);
+    }
+
+    // Terminator, byte alignment and alternating pad bytes
+    append(0, std::min<std::size_t>(4, 8*capacity - bits.size()));
+    append(0, (8 - bits.size() % 8) % 8);
+    for (std::uint8_t pad = 0xEC; bits.size() < 8*capacity; pad ^= 0xEC ^ 0x11) {
+        append(pad, 8);
+    }
+
+    std::vector<std::uint8_t> data(capacity, 0);
+    for (std::size_t i = 0; i < bits.size(); i++) {
+        data[i >> 3] |= bits[i] << (7 - (i & 7));
+    }
+
+    size_ = 4*version_ + 17;
+    modules_.assign(size_*size_, false);
+    function_.assign(size_*size_, false);
+
+    drawFunctionPatterns();
+    drawCodewords(addErrorCorrection(data));
+
+    int best = 0;
+    long minPenalty = LONG_MAX;
+    for (int mask = 0; mask < 8; mask++) {
+        applyMask(mask);
+        drawFormatBits(mask);
+
+        long p = penalty();
+        if (p < minPenalty) {
+            best = mask;
+            minPenalty = p;
+        }
+
+        applyMask(mask); // XOR undoes the mask
+    }
+
+    applyMask(best);
+    drawFormatBits(best);
+}
+
+void Elliptic::QRCode::setFunction(int x, int y, bool dark) {
+    modules_[y*size_ + x] = dark;
+    function_[y*size_ + x] = true;
+}
+
+/**
+ * Draws the timing, finder and alignment patterns and reserves the format
+ * (and version) areas.
+ */
+void Elliptic::QRCode::drawFunctionPatterns() {
+    for (int i = 0; i < size_; i++) {
+        setFunction(6, i, i % 2 == 0);
+        setFunction(i, 6, i % 2 == 0);
+    }
+
+    const int finders[3][2] = { { 3, 3 }, { size_ - 4, 3 }, { 3, size_ - 4 } };
+    for (const auto& finder : finders) {
+        for (int dy = -4; dy <= 4; dy++) {
+            for (int dx = -4; dx <= 4; dx++) {
+                int x = finder[0] + dx, y = finder[1] + dy;
+                int distance = std::max(std::abs(dx), std::abs(dy));
+                if (x >= 0 && x < size_ && y >= 0 && y < size_) {
+                    setFunction(x, y, distance != 2 && distance != 4);
+                }
+            }
+        }
+    }
+
+    std::vector<int> positions = alignmentPositions();
+    std::size_t count = positions.size();
+    for (std::size_t i = 0; i < count; i++) {
+        for (std::size_t j = 0; j < count; j++) {
+            // Skip the three corners occupied by finder patterns
+            if ((i == 0 && j == 0) || (i == 0 && j == count - 1) || (i == count - 1 && j == 0)) {
+                continue;
+            }
+
+            for (int dy = -2; dy <= 2; dy++) {
+                for (int dx = -2; dx <= 2; dx++) {
+                    setFunction(positions[i] + dx, positions[j] + dy,
+                        std::max(std::abs(dx), std::abs(dy)) != 1);
+                }
+            }
+        }
+    }
+
+    drawFormatBits(0);
+
+    if (version_ >= 7) {
+        // 6-bit version with an 18-bit BCH code, generator 0x1F25
+        int remainder = version_;
+        for (int i = 0; i < 12; i++) {
+            remainder = (remainder << 1) ^ ((remainder >> 11) * 0x1F25);
+        }
+
+        long bits = static_cast<long>(version_) << 12 | remainder;
+        for (int i = 0; i < 18; i++) {
+            bool dark = ((bits >> i) & 1) != 0;
+            int a = size_ - 11 + i % 3, b = i / 3;
+            setFunction(a, b, dark);
+            setFunction(b, a, dark);
+        }
+    }
+}
+
+/**
+ * Draws both copies of the 15-bit format information (level M and the mask).
+ */
+void Elliptic::QRCode::drawFormatBits(int mask) {
+    int data = mask; // Level M has format bits 00
+    int remainder = data;
+    for (int i = 0; i < 10; i++) {
+        remainder = (remainder << 1) ^ ((remainder >> 9) * 0x537);
+    }
+
+    int bits = (data << 10 | remainder) ^ 0x5412;
+    auto bit = [bits](int i) { return ((bits >> i) & 1) != 0; };
+
+    for (int i = 0; i <= 5; i++) {
+        setFunction(8, i, bit(i));
+    }
+
+    setFunction(8, 7, bit(6));
+    setFunction(8, 8, bit(7));
+    setFunction(7, 8, bit(8));
+    for (int i = 9; i < 15; i++) {
+        setFunction(14 - i, 8, bit(i));
+    }
+
+    for (int i = 0; i < 8; i++) {
+        setFunction(size_ - 1 - i, 8, bit(i));
+    }
+
+    for (int i = 8; i < 15; i++) {
+        setFunction(8, size_ - 15 + i, bit(i));
+    }
+
+    setFunction(8, size_ - 8, true); // Always dark
+}
+
+/**
+ * Places the codewords in the zig-zag pattern of two-module wide columns,
+ * starting from the bottom right corner.
+ */
+void Elliptic::QRCode::drawCodewords(const std::vector<std::uint8_t>& codewords) {
+    std::size_t i = 0;
+    for (int right = size_ - 1; right >= 1; right -= 2) {
+        if (right == 6) {
+            right = 5; // Skip the vertical timing pattern
+        }
+
+        bool upward = ((right + 1) & 2) == 0;
+        for (int vertical = 0; vertical < size_; vertical++) {
+            for (int j = 0; j < 2; j++) {
+                int x = right - j;
+                int y = upward ? size_ - 1 - vertical : vertical;
+                if (!function_[y*size_ + x] && i < 8*codewords.size()) {
+                    modules_[y*size_ + x] = ((codewords[i >> 3] >> (7 - (i & 7))) & 1) != 0;
+                    i++;
+                }
+            }
+        }
+    }
+}
+
+void Elliptic::QRCode::applyMask(int mask) {
+    for (int y = 0; y < size_; y++) {
+        for (int x = 0; x < size_; x++) {
+            bool invert;
+            switch (mask) {
+                case 0: invert = (x + y) % 2 == 0; break;
+                case 1: invert = y % 2 == 0; break;
+                case 2: invert = x % 3 == 0; break;
+                case 3: invert = (x + y) % 3 == 0; break;
+                case 4: invert = (x / 3 + y / 2) % 2 == 0; break;
+                case 5: invert = x*y % 2 + x*y % 3 == 0; break;
+                case 6: invert = (x*y % 2 + x*y % 3) % 2 == 0; break;
+                default: invert = ((x + y) % 2 + x*y % 3) % 2 == 0; break;
+            }
+
+            if (invert && !function_[y*size_ + x]) {
+                modules_[y*size_ + x] = !modules_[y*size_ + x];
+            }
+        }
+    }
+}
+
+/**
+ * Penalty score of the current symbol: runs of five or more equal modules,
+ * 2x2 blocks, finder-like 1:1:3:1:1 patterns and dark/light imbalance.
+ */
+long Elliptic::QRCode::penalty() const {
+    long result = 0;
+    auto dark = [this](int x, int y) { return modules_[y*size_ + x]; };
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < size_; i++) {
+            int run = 1;
+            std::uint32_t history = 0;
+            for (int j = 0; j < size_; j++) {
+                bool module = pass == 0 ? dark(j, i) : dark(i, j);
+                if (j > 0) {
+                    bool previous = pass == 0 ? dark(j - 1, i) : dark(i, j - 1);
+                    if (module == previous) {
+                        run++;
+                        if (run == 5) {
+                            result += 3;
+                        } else if (run > 5) {
+                            result++;
+                        }
+                    } else {
+                        run = 1;
+                    }
+                }
+
+                // 1011101 preceded or followed by four light modules
+                history = ((history << 1) | module) & 0x7FF;
+                if (j >= 10 && (history == 0x05D || history == 0x5D0)) {
+                    result += 40;
+                }
+            }
+        }
+    }
+
+    long darkCount = 0;
+    for (int y = 0; y < size_; y++) {
+        for (int x = 0; x < size_; x++) {
+            darkCount += dark(x, y);
+            if (x + 1 < size_ && y + 1 < size_ && dark(x, y) == dark(x + 1, y)
+                    && dark(x, y) == dark(x, y + 1) && dark(x, y) == dark(x + 1, y + 1)) {
+                result += 3;
+            }
+        }
+    }
+
+    long total = size_*size_;
+    long k = (std::abs(darkCount*20 - total*10) + total - 1) / total - 1;
+    return result + 10*std::max(0L, k);
+}
+
+std::vector<int> Elliptic::QRCode::alignmentPositions() const {
+    if (version_ == 1) {
+        return std::vector<int>();
+    }
+
+    int count = version_ / 7 + 2;
+    int step = (version_*4 + count*2 + 1) / (count*2 - 2) * 2;
+
+    std::vector<int> positions(count);
+    positions[0] = 6;
+    for (int i = count - 1, position = size_ - 7; i >= 1; i--, position -= step) {
+        positions[i] = position;
+    }
+
+    return positions;
+}
+
+/**
+ * Splits the data into blocks, appends the Reed-Solomon error correction
+ * codewords of each block and interleaves the blocks.
+ */
+std::vector<std::uint8_t> Elliptic::QRCode::addErrorCorrection(
+        const std::vector<std::uint8_t>& data) const {
+    int blocks = BLOCKS[version_], eccLength = ECC_CODEWORDS[version_];
+    int raw = rawCodewords(version_);
+    int shortBlocks = blocks - raw % blocks;
+    int shortLength = raw / blocks;
+
+    // Generator polynomial (x - 2^0)(x - 2^1)...(x - 2^{eccLength-1}), leading
+    // coefficient omitted
+    std::vector<std::uint8_t> divisor(eccLength, 0);
+    divisor.back() = 1;
+    std::uint8_t root = 1;
+    for (int i = 0; i < eccLength; i++) {
+        for (int j = 0; j < eccLength; j++) {
+            divisor[j] = multiply(divisor[j], root);
+            if (j + 1 < eccLength) {
+                divisor[j] ^= divisor[j + 1];
+            }
+        }
+
+        root = multiply(root, 0x02);
+    }
+
+    std::vector<std::vector<std::uint8_t>> blockData;
+    for (int i = 0, k = 0; i < blocks; i++) {
+        int length = shortLength - eccLength + (i < shortBlocks ? 0 : 1);
+        std::vector<std::uint8_t> block(data.begin() + k, data.begin() + k + length);
+        k += length;
+
+        std::vector<std::uint8_t> remainder(eccLength, 0);
+        for (std::uint8_t b : block) {
+            std::uint8_t factor = b ^ remainder[0];
+            remainder.erase(remainder.begin());
+            remainder.push_back(0);
+            for (int j = 0; j < eccLength; j++) {
+                remainder[j] ^= multiply(divisor[j], factor);
+            }
+        }
+
+        if (i < shortBlocks) {
+            block.push_back(0); // Placeholder, skipped when interleaving
+        }
+
+        block.insert(block.end(), remainder.begin(), remainder.end());
+        blockData.push_back(block);
+    }
+
+    std::vector<std::uint8_t> result;
+    result.reserve(raw);
+    for (std::size_t i = 0; i < blockData[0].size(); i++) {
+        for (int j = 0; j < blocks; j++) {
+            if (static_cast<int>(i) != shortLength - eccLength || j >= shortBlocks) {
+                result.push_back(blockData[j][i]);
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Number of 8-bit codewords available for data and error correction.
+ */
+int Elliptic::QRCode::rawCodewords(int version) {
+    int bits = (16*version + 128)*version + 64;
+    if (version >= 2) {
+        int alignments = version / 7 + 2;
+        bits -= (25*alignments - 10)*alignments - 55;
+        if (version >= 7) {
+            bits -= 36;
+        }
+    }
+
+    return bits / 8;
+}
+
+/**
+ * Multiplication in GF(2^8) modulo x^8 + x^4 + x^3 + x^2 + 1.
+ */
+std::uint8_t Elliptic::QRCode::multiply(std::uint8_t x, std::uint8_t y) {
+    int z = 0;
+    for (int i = 7; i >= 0; i--) {
+        z = (z << 1) ^ ((z >> 7) * 0x11D);
+        z ^= ((y >> i) & 1) * x;
+    }
+
+    return z;
+}
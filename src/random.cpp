@@ -0,0 +1,262 @@
+#include "random.h"
+
+#include <algorithm> // std::min
+#include <cerrno>    // errno, EINTR
+#include <cstring>   // std::memcmp, std::memcpy, std::memmove, std::memset
+#include <stdexcept> // std::invalid_argument, std::runtime_error
+
+#include <sys/random.h> // getrandom
+#include <unistd.h>     // getpid
+
+namespace {
+
+    const std::size_t BUFFER = 4096;
+    const std::size_t RESEED = 1 << 24;
+
+    const Elliptic::Random::Scalar ZERO = {};
+
+    std::uint32_t rotate(std::uint32_t x, int n) {
+        return (x << n) | (x >> (32 - n));
+    }
+
+    void quarterRound(std::uint32_t* s, int a, int b, int c, int d) {
+        s[a] += s[b]; s[d] = rotate(s[d] ^ s[a], 16);
+        s[c] += s[d]; s[b] = rotate(s[b] ^ s[c], 12);
+        s[a] += s[b]; s[d] = rotate(s[d] ^ s[a], 8);
+        s[c] += s[d]; s[b] = rotate(s[b] ^ s[c], 7);
+    }
+
+    void seed(void* output, std::size_t length) {
+        std::uint8_t* out = static_cast<std::uint8_t*>(output);
+        while (length > 0) {
+            ssize_t n = getrandom(out, length, 0);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+
+            if (n < 0) {
+                throw std::runtime_error("Unable to read random bytes from the operating system");
+            }
+
+            out += n;
+            length -= n;
+        }
+    }
+
+    /**
+     * Thread-local generator state. The first 32 bytes of every refill become
+     * the next key so earlier output cannot be recovered from the state.
+     */
+    struct Generator {
+        std::uint32_t key[8];
+        std::uint8_t buffer[BUFFER];
+        std::size_t position = BUFFER;
+        std::size_t generated = 0;
+        pid_t pid = 0;
+
+        ~Generator() {
+            std::memset(key, 0, sizeof(key));
+            std::memset(buffer, 0, sizeof(buffer));
+        }
+
+        void refill() {
+            if (pid != getpid() || generated >= RESEED) {
+                std::uint32_t entropy[8];
+                seed(entropy, sizeof(entropy));
+                for (int i = 0; i < 8; i++) {
+                    key[i] = (pid == 0 ? 0 : key[i]) ^ entropy[i];
+                }
+
+                pid = getpid();
+                generated = 0;
+            }
+
+            const std::uint32_t nonce[3] = { 0, 0, 0 };
+            std::uint8_t block[64];
+            Elliptic::Random::chacha20(key, 0, nonce, block);
+            for (std::size_t i = 0; i < BUFFER / 64; i++) {
+                Elliptic::Random::chacha20(key, i + 1, nonce, buffer + 64*i);
+            }
+
+            std::memcpy(key, block, sizeof(key));
+            std::memset(block, 0, sizeof(block));
+
+            position = 0;
+            generated += BUFFER;
+        }
+
+        void read(std::uint8_t* output, std::size_t length) {
+            // A forked child must not serve the parent's buffered keystream
+            if (pid != 0 && pid != getpid()) {
+                std::memset(buffer, 0, sizeof(buffer));
+                position = BUFFER;
+            }
+
+            while (length > 0) {
+                if (position == BUFFER) {
+                    refill();
+                }
+
+                std::size_t n = std::min(length, BUFFER - position);
+                std::memcpy(output, buffer + position, n);
+                std::memset(buffer + position, 0, n);
+
+                position += n;
+                output += n;
+                length -= n;
+            }
+        }
+    };
+
+    thread_local Generator generator;
+
+}
+
+/**
+ * Fills the output with cryptographically secure random bytes.
+ */
+void Elliptic::Random::bytes(std::uint8_t* output, std::size_t length) {
+    generator.read(output, length);
+}
+
+/**
+ * Uniform scalar in 1 to n - 1, see `scalars`.
+ */
+Elliptic::Random::Scalar Elliptic::Random::scalar(const mpz_class& n) {
+    return scalars(n, 1)[0];
+}
+
+/**
+ * Generates uniform scalars in 1 to n - 1 (e.g., private keys for a curve of
+ * order n) by rejection sampling. Candidates are compared with n byte by byte,
+ * so no big integers are created per scalar.
+ */
+std::vector<Elliptic::Random::Scalar> Elliptic::Random::scalars(const mpz_class& n,
+        std::size_t count) {
+    std::size_t bits = mpz_sizeinbase(n.get_mpz_t(), 2);
+    if (cmp(n, 1) <= 0 || bits > 256) {
+        throw std::invalid_argument("Order must be greater than 1 and at most 256 bits");
+    }
+
+    Scalar limit = {};
+    std::size_t length;
+    mpz_export(limit.data(), &length, 1, 1, 1, 0, n.get_mpz_t());
+    std::memmove(limit.data() + limit.size() - length, limit.data(), length);
+    std::memset(limit.data(), 0, limit.size() - length);
+
+    // Discard bits above the bit length of n so at least half the candidates pass
+    std::size_t skip = 32 - (bits + 7) / 8;
+    std::uint8_t mask = 0xFF >> ((8 - bits % 8) % 8);
+
+    std::vector<Scalar> output(count);
+    std::vector<std::uint8_t> candidates(count * (32 - skip));
+    std::size_t filled = 0;
+    while (filled < count) {
+        std::size_t remaining = count - filled;
+        std::uint8_t* candidate = candidates.data();
+        bytes(candidate, remaining * (32 - skip));
+
+        for (std::size_t i = 0; i < remaining; i++, candidate += 32 - skip) {
+            Scalar& s = output[filled];
+            std::memset(s.data(), 0, skip);
+            std::memcpy(s.data() + skip, candidate, 32 - skip);
+            s[skip] &= mask;
+
+            // 0 < s < n, comparing big-endian bytes
+            if (std::memcmp(s.data(), limit.data(), s.size()) < 0
+                    && std::memcmp(s.data(), ZERO.data(), s.size()) != 0) {
+                filled++;
+            }
+        }
+    }
+
+    std::memset(candidates.data(), 0, candidates.size());
+    return output;
+}
+
+/**
+ * The ChaCha20 block function (RFC 7539), writing 64 bytes of keystream.
+ */
+void Elliptic::Random::chacha20(const std::uint32_t key[8], std::uint32_t counter,
+        const std::uint32_t nonce[3], std::uint8_t output[64]) {
+    std::uint32_t state[16] = {
+        0x61707865, 0x3320646E, 0x79622D32, 0x6B206574,
+        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+        counter, nonce[0], nonce[1], nonce[2]
+    };
+
+    std::uint32_t s[16];
+    std::memcpy(s, state, sizeof(s));
+    for (int i = 0; i < 10; i++) {
+        quarterRound(s, 0, 4, 8, 12);
+        quarterRound(s, 1, 5, 9, 13);
+        quarterRound(s, 2, 6, 10, 14);
+        quarterRound(s, 3, 7, 11, 15);
+        quarterRound(s, 0, 5, 10, 15);
+        quarterRound(s, 1, 6, 11, 12);
+        quarterRound(s, 2, 7, 8, 13);
+        quarterRound(s, 3, 4, 9, 14);
+    }
+
+    for (int i = 0; i < 16; i++) {
+        std::uint32_t word = s[i] + state[i];
+        output[4*i] = word;
+        output[4*i + 1] = word >> 8;
+        output[4*i + 2] = word >> 16;
+        output[4*i + 3] = word >> 24;
+    }
+}
+
+Elliptic::FastRandom::FastRandom() {
+    do {
+        seed(state_, sizeof(state_));
+    } while ((state_[0] | state_[1] | state_[2] | state_[3]) == 0);
+}
+
+/**
+ * The generator for the calling thread.
+ */
+Elliptic::FastRandom& Elliptic::FastRandom::local() {
+    thread_local FastRandom random;
+    return random;
+}
+
+std::uint64_t Elliptic::FastRandom::next() {
+    std::uint64_t result = state_[1] * 5;
+    result = ((result << 7) | (result >> 57)) * 9;
+
+    std::uint64_t t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = (state_[3] << 45) | (state_[3] >> 19);
+
+    return result;
+}
+
+/**
+ * Uniform number in 0 to n - 1 by rejection sampling.
+ */
+mpz_class Elliptic::FastRandom::uniform(const mpz_class& n) {
+    if (sgn(n) <= 0) {
+        throw std::invalid_argument("n must be greater than 0");
+    }
+
+    std::size_t bits = mpz_sizeinbase(n.get_mpz_t(), 2);
+    std::vector<std::uint64_t> words((bits + 63) / 64);
+    std::uint64_t mask = bits % 64 == 0 ? ~0ULL : (1ULL << (bits % 64)) - 1;
+
+    mpz_class r;
+    do {
+        for (std::uint64_t& word : words) {
+            word = next();
+        }
+
+        words.back() &= mask;
+        mpz_import(r.get_mpz_t(), words.size(), -1, sizeof(std::uint64_t), 0, 0, words.data());
+    } while (cmp(r, n) >= 0);
+
+    return r;
+}
@@ -0,0 +1,374 @@
+#include "recovery.h"
+
+#include <algorithm> // std::min, std::sort, std::transform, std::unique
+#include <chrono>    // std::chrono::steady_clock
+#include <cstdio>    // std::rename
+#include <cstring>   // std::memcmp
+#include <fstream>   // std::ifstream, std::ofstream
+#include <mutex>     // std::mutex, std::lock_guard
+#include <stdexcept> // std::invalid_argument, std::runtime_error
+
+#include "base58.h"
+
+const char Elliptic::Recovery::WILDCARD = '?';
+
+const std::uint64_t Elliptic::Recovery::BLOCK = 1 << 16;
+const std::size_t Elliptic::Recovery::LANES = 256;
+const int Elliptic::Recovery::CHECKPOINT_SECONDS = 10;
+
+/**
+ * Parses a WIF (51 or 52 characters) or dice (99 digits) private key where
+ * every unreadable character is replaced by WILDCARD.
+ */
+Elliptic::Recovery::Recovery(const std::string& pattern) : table_(curve_, bitcoin_.getBasePoint()),
+        pattern_(pattern) {
+    dice_ = pattern.length() == 99;
+    if (!dice_ && pattern.length() != 51 && pattern.length() != 52) {
+        throw std::invalid_argument("Pattern must be a WIF or 99 digit dice private key");
+    }
+
+    radix_ = dice_ ? 6 : 58;
+    bytes_ = pattern.length() == 52 ? 38 : 37; // 0x80, key, [0x01], checksum
+
+    base_ = 0;
+    mpz_class weight = 1;
+    for (std::size_t i = pattern.length(); i-- > 0; weight *= radix_) {
+        char c = pattern[i];
+        if (c == WILDCARD) {
+            weights_.push_back(weight);
+            continue;
+        }
+
+        std::size_t digit = dice_ ? c - '0' : Base58::BASE58.find(c);
+        if (digit >= radix_) {
+            throw std::invalid_argument("Pattern contains an invalid character");
+        }
+
+        base_ += weight*digit;
+    }
+
+    mpz_class candidates;
+    mpz_ui_pow_ui(candidates.get_mpz_t(), radix_, weights_.size());
+    if (mpz_sizeinbase(candidates.get_mpz_t(), 2) > 63) {
+        throw std::invalid_argument("Pattern contains too many wildcards");
+    }
+
+    candidates_ = candidates.get_ui();
+
+    // Incrementing wildcard j resets every less significant wildcard from
+    // radix - 1 to 0
+    mpz_class lower = 0;
+    for (const mpz_class& w : weights_) {
+        deltas_.push_back(w - (radix_ - 1)*lower);
+        lower += w;
+    }
+
+    if (dice_) {
+        mpz_class n = curve_.getOrder();
+        for (const mpz_class& delta : deltas_) {
+            mpz_class d;
+            mpz_mod(d.get_mpz_t(), delta.get_mpz_t(), n.get_mpz_t());
+            deltaPoints_.push_back(sgn(d) == 0 ? Point() : table_.multiply(d));
+        }
+    }
+}
+
+/**
+ * Adds an address or hexadecimal hash160 that recovered keys must match.
+ * Without targets, every WIF candidate with a valid checksum is a match.
+ */
+void Elliptic::Recovery::addTarget(const std::string& target) {
+    std::string hash160 = target;
+    if (target.length() != 40 || target.find_first_not_of("0123456789ABCDEFabcdef") != std::string::npos) {
+        std::string hex = Base58::base58ToHex(target);
+        if (hex.length() > 50) {
+            throw std::invalid_argument("Address " + target + " is invalid");
+        }
+
+        hex = std::string(50 - hex.length(), '0') + hex;
+        std::string sha = Hash::sha256(Hash::sha256(hex.substr(0, 42)));
+        if (hex.compare(42, 8, sha, 0, 8) != 0) {
+            throw std::invalid_argument("SHA-256 checksum is incorrect");
+        }
+
+        hash160 = hex.substr(2, 40);
+    }
+
+    std::transform(hash160.begin(), hash160.end(), hash160.begin(), ::tolower);
+    targets_.insert(hash160);
+}
+
+/**
+ * Searches every candidate and returns the matches. With a checkpoint path,
+ * progress is saved there periodically and a search is resumed from it if it
+ * already exists. The progress callback is called after every block.
+ */
+std::vector<Elliptic::Recovery::Match> Elliptic::Recovery::search(const std::string& checkpoint,
+        const Progress& progress, unsigned workers) const {
+    if (dice_ && targets_.empty()) {
+        throw std::invalid_argument("Dice keys have no checksum, a target address is required");
+    }
+
+    std::uint64_t blocks = (candidates_ + BLOCK - 1)/BLOCK;
+    std::uint64_t start = 0;
+    std::vector<Match> matches;
+    if (!checkpoint.empty()) {
+        loadCheckpoint(checkpoint, start, matches);
+    }
+
+    // Blocks finish out of order, so only the contiguous prefix is checkpointed
+    std::vector<bool> finished(blocks - start, false);
+    std::uint64_t watermark = start;
+    std::uint64_t done = std::min(start*BLOCK, candidates_);
+    auto saved = std::chrono::steady_clock::now();
+    std::mutex mutex;
+
+    Parallel::forEach(blocks - start, [&](std::size_t i) {
+        std::vector<Match> found;
+        searchBlock(start + i, found);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        matches.insert(matches.end(), found.begin(), found.end());
+        finished[i] = true;
+        while (watermark < blocks && finished[watermark - start]) {
+            watermark++;
+        }
+
+        done += std::min(BLOCK, candidates_ - (start + i)*BLOCK);
+        if (progress) {
+            progress(done, candidates_);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (!checkpoint.empty() && now - saved >= std::chrono::seconds(CHECKPOINT_SECONDS)) {
+            saveCheckpoint(checkpoint, watermark, matches);
+            saved = now;
+        }
+    }, workers);
+
+    if (!checkpoint.empty()) {
+        saveCheckpoint(checkpoint, blocks, matches);
+    }
+
+    // Blocks past the watermark of a resumed checkpoint may be found twice
+    std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+        return a.privateHex != b.privateHex ? a.privateHex < b.privateHex : a.compressed < b.compressed;
+    });
+    matches.erase(std::unique(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+        return a.privateHex == b.privateHex && a.compressed == b.compressed;
+    }), matches.end());
+
+    return matches;
+}
+
+void Elliptic::Recovery::searchBlock(std::uint64_t block, std::vector<Match>& matches) const {
+    std::uint64_t first = block*BLOCK;
+    std::uint64_t count = std::min(BLOCK, candidates_ - first);
+    if (dice_) {
+        searchDice(first, count, matches);
+    } else {
+        searchWIF(first, count, matches);
+    }
+}
+
+/**
+ * Walks the candidate values by adding the precomputed delta of the wildcard
+ * that is incremented, so each candidate costs one addition on the value, the
+ * prefix and compression byte checks, and usually one double SHA-256.
+ */
+void Elliptic::Recovery::searchWIF(std::uint64_t first, std::uint64_t count,
+        std::vector<Match>& matches) const {
+    std::vector<unsigned> digits(weights_.size());
+    for (std::size_t j = 0, c = first; j < digits.size(); j++, c /= radix_) {
+        digits[j] = c % radix_;
+    }
+
+    mpz_class v = value(first);
+    mpz_class n = curve_.getOrder();
+    std::uint8_t data[38], hash[32], checksum[32];
+    for (std::uint64_t i = 0; i < count; i++) {
+        if (i > 0) {
+            v += deltas_[carry(digits)];
+        }
+
+        std::size_t size = (mpz_sizeinbase(v.get_mpz_t(), 2) + 7)/8;
+        if (size != bytes_) { // Leading byte 0x80 is never zero
+            continue;
+        }
+
+        mpz_export(data, nullptr, 1, 1, 1, 0, v.get_mpz_t());
+        if (data[0] != 0x80 || (bytes_ == 38 && data[33] != 0x01)) {
+            continue;
+        }
+
+        Hash::sha256(data, bytes_ - 4, hash);
+        Hash::sha256(hash, sizeof(hash), checksum);
+        if (std::memcmp(checksum, data + bytes_ - 4, 4) != 0) {
+            continue;
+        }
+
+        mpz_class k;
+        mpz_import(k.get_mpz_t(), 32, 1, 1, 1, 0, data + 1);
+        if (sgn(k) == 0 || cmp(k, n) >= 0) {
+            continue;
+        }
+
+        bool compressed = bytes_ == 38;
+        if (!targets_.empty() && !isTarget(table_.multiply(k), compressed)) {
+            continue;
+        }
+
+        std::string privateHex = Hash::byteToHex(data + 1, 32);
+        std::transform(privateHex.begin(), privateHex.end(), privateHex.begin(), ::toupper);
+        matches.push_back({ privateHex, compressed });
+    }
+}
+
+/**
+ * Splits the block into lanes of consecutive candidates and advances the
+ * public keys of all lanes together, so each candidate costs one point
+ * addition sharing its inversion with the other lanes instead of a scalar
+ * multiplication. Both address forms are checked.
+ */
+void Elliptic::Recovery::searchDice(std::uint64_t first, std::uint64_t count,
+        std::vector<Match>& matches) const {
+    std::size_t lanes = std::min<std::uint64_t>(LANES, count);
+    std::uint64_t steps = (count + lanes - 1)/lanes;
+    mpz_class n = curve_.getOrder();
+
+    std::vector<std::vector<unsigned>> digits(lanes, std::vector<unsigned>(weights_.size()));
+    std::vector<std::uint64_t> lengths(lanes, 0);
+    std::vector<mpz_class> values(lanes), scalars;
+    std::vector<std::size_t> nonzero;
+    for (std::size_t l = 0; l < lanes && l*steps < count; l++) {
+        std::uint64_t c = first + l*steps;
+        lengths[l] = std::min(steps, count - l*steps);
+        values[l] = value(c);
+        for (std::size_t j = 0; j < weights_.size(); j++, c /= radix_) {
+            digits[l][j] = c % radix_;
+        }
+
+        mpz_class k;
+        mpz_mod(k.get_mpz_t(), values[l].get_mpz_t(), n.get_mpz_t());
+        if (sgn(k) != 0) {
+            scalars.push_back(k);
+            nonzero.push_back(l);
+        }
+    }
+
+    std::vector<Point> points(lanes), deltas(lanes), starts = table_.multiply(scalars);
+    for (std::size_t i = 0; i < nonzero.size(); i++) {
+        points[nonzero[i]] = starts[i];
+    }
+
+    for (std::uint64_t s = 0; s < steps; s++) {
+        if (s > 0) {
+            for (std::size_t l = 0; l < lanes; l++) {
+                deltas[l] = Point();
+                if (s < lengths[l]) {
+                    std::size_t j = carry(digits[l]);
+                    values[l] += deltas_[j];
+                    deltas[l] = deltaPoints_[j];
+                }
+            }
+
+            curve_.add(points, deltas);
+        }
+
+        for (std::size_t l = 0; l < lanes; l++) {
+            if (s >= lengths[l] || sgn(values[l]) == 0 || cmp(values[l], n) >= 0) {
+                continue;
+            }
+
+            for (bool compressed : { true, false }) {
+                if (isTarget(points[l], compressed)) {
+                    std::string privateHex = values[l].get_str(16);
+                    privateHex = std::string(64 - privateHex.length(), '0') + privateHex;
+                    std::transform(privateHex.begin(), privateHex.end(), privateHex.begin(), ::toupper);
+                    matches.push_back({ privateHex, compressed });
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Pattern value of the given candidate number.
+ */
+mpz_class Elliptic::Recovery::value(std::uint64_t candidate) const {
+    mpz_class v = base_;
+    for (const mpz_class& w : weights_) {
+        v += w*static_cast<unsigned long>(candidate % radix_);
+        candidate /= radix_;
+    }
+
+    return v;
+}
+
+/**
+ * Increments the wildcard digits (least significant first) and returns the
+ * index of the wildcard that was incremented.
+ */
+std::size_t Elliptic::Recovery::carry(std::vector<unsigned>& digits) const {
+    std::size_t j = 0;
+    while (digits[j] == radix_ - 1) {
+        digits[j++] = 0;
+    }
+
+    digits[j]++;
+    return j;
+}
+
+bool Elliptic::Recovery::isTarget(const Point& p, bool compressed) const {
+    if (p.isZero()) {
+        return false;
+    }
+
+    std::string publicKey = bitcoin_.pointToPublicKey(p, compressed);
+    return targets_.count(Hash::ripemd160(Hash::sha256(publicKey))) != 0;
+}
+
+/**
+ * Reads the number of finished blocks and the matches found so far. A missing
+ * file starts a new search.
+ */
+void Elliptic::Recovery::loadCheckpoint(const std::string& path, std::uint64_t& done,
+        std::vector<Match>& matches) const {
+    std::ifstream file(path);
+    if (!file) {
+        return;
+    }
+
+    std::string magic, pattern;
+    std::uint64_t blocks = 0;
+    file >> magic >> pattern >> done >> blocks;
+    if (!file || magic != "elliptic-recovery" || pattern != pattern_
+            || blocks != (candidates_ + BLOCK - 1)/BLOCK || done > blocks) {
+        throw std::invalid_argument("Checkpoint " + path + " does not belong to this search");
+    }
+
+    Match match;
+    while (file >> match.privateHex >> match.compressed) {
+        matches.push_back(match);
+    }
+}
+
+/**
+ * Writes the checkpoint to a temporary file first so that an interrupted
+ * write never loses the previous checkpoint.
+ */
+void Elliptic::Recovery::saveCheckpoint(const std::string& path, std::uint64_t done,
+        const std::vector<Match>& matches) const {
+    std::string temporary = path + ".tmp";
+    std::ofstream file(temporary, std::ios::trunc);
+    file << "elliptic-recovery\n" << pattern_ << "\n" << done << " "
+        << (candidates_ + BLOCK - 1)/BLOCK << "\n";
+    for (const Match& match : matches) {
+        file << match.privateHex << " " << match.compressed << "\n";
+    }
+
+    file.close();
+    if (!file || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Unable to save checkpoint " + path);
+    }
+}
@@ -0,0 +1,11 @@
+#include "secp256r1.h"
+
+// y^2 = x^3 + Ax + B (mod PRIME), A = -3
+const std::string Elliptic::Secp256r1::A = "FFFFFFFF00000001000000000000000000000000FFFFFFFFFFFFFFFFFFFFFFFC";
+const std::string Elliptic::Secp256r1::B = "5AC635D8AA3A93E7B3EBBD55769886BC651D06B0CC53B0F63BCE3C3E27D2604B";
+
+const std::string Elliptic::Secp256r1::PRIME = "FFFFFFFF00000001000000000000000000000000FFFFFFFFFFFFFFFFFFFFFFFF";
+const std::string Elliptic::Secp256r1::ORDER = "FFFFFFFF00000000FFFFFFFFFFFFFFFFBCE6FAADA7179E84F3B9CAC2FC632551";
+
+const std::string Elliptic::Secp256r1::GX = "6B17D1F2E12C4247F8BCE6E563A440F277037D812DEB33A0F4A13945D898C296";
+const std::string Elliptic::Secp256r1::GY = "4FE342E2FE1A7F9B8EE7EB4A7C0F9E162BCE33576B315ECECBB6406837BF51F5";
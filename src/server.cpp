@@ -0,0 +1,706 @@
+#include "server.h"
+
+#include <algorithm>     // std::max, std::min, std::nth_element, std::sort, std::unique
+#include <cerrno>        // errno, EAGAIN, EWOULDBLOCK, EINTR, ENOENT
+#include <cstring>       // std::memcpy, std::strerror
+#include <exception>     // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <memory>        // std::unique_ptr
+#include <stdexcept>     // std::invalid_argument, std::runtime_error
+#include <thread>        // std::thread
+#include <unordered_map> // std::unordered_map
+#include <utility>       // std::move
+
+#include <sys/epoll.h>   // epoll_create1, epoll_ctl, epoll_wait
+#include <sys/eventfd.h> // eventfd
+#include <sys/socket.h>  // socket, bind, listen, accept4, connect, send, recv, shutdown
+#include <sys/stat.h>    // lstat, S_ISSOCK
+#include <sys/timerfd.h> // timerfd_create, timerfd_settime
+#include <sys/un.h>      // sockaddr_un
+#include <unistd.h>      // close, read, write, unlink
+
+#include "pipeline.h"
+
+const std::size_t Elliptic::Server::REQUEST_SIZE;
+const std::size_t Elliptic::Server::RESPONSE_HEADER;
+const std::uint8_t Elliptic::Server::COMPRESSED;
+const std::size_t Elliptic::Server::LATENCIES = 1 << 16;
+
+struct Elliptic::Server::Request {
+    std::uint64_t connection;
+    std::uint32_t id;
+    std::uint8_t op, flags;
+    std::uint8_t key[32];
+    std::chrono::steady_clock::time_point arrival;
+};
+
+struct Elliptic::Server::Response {
+    std::uint64_t connection;
+    std::chrono::steady_clock::time_point arrival;
+    bool failed;
+    std::string frame;
+};
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    // epoll tokens, connections are numbered from CONNECTIONS on
+    const std::uint64_t LISTENER = 0, WAKE = 1, TIMER = 2, CONNECTIONS = 3;
+
+    struct Connection {
+        int fd;
+        std::string input, output;
+        std::size_t outstanding; // Requests waiting for a batch or being derived
+        std::uint32_t events;    // Currently watched
+        bool closed;             // The client has shut down its sending side
+    };
+
+    void check(int result, const std::string& what) {
+        if (result < 0) {
+            throw std::runtime_error(what + ": " + std::strerror(errno));
+        }
+    }
+
+    sockaddr_un address(const std::string& path) {
+        sockaddr_un address = {};
+        if (path.empty() || path.length() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("Invalid socket path " + path);
+        }
+
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.length() + 1);
+        return address;
+    }
+
+    void watch(int epoll, int op, int fd, std::uint64_t token, std::uint32_t events) {
+        epoll_event event = {};
+        event.events = events;
+        event.data.u64 = token;
+        check(epoll_ctl(epoll, op, fd, &event), "epoll_ctl");
+    }
+
+    void putLittleEndian(std::string& output, std::uint64_t value, std::size_t bytes) {
+        for (std::size_t i = 0; i < bytes; i++) {
+            output += static_cast<char>((value >> (8*i)) & 0xFF);
+        }
+    }
+
+    std::uint64_t getLittleEndian(const std::uint8_t* input, std::size_t bytes) {
+        std::uint64_t value = 0;
+        for (std::size_t i = 0; i < bytes; i++) {
+            value |= static_cast<std::uint64_t>(input[i]) << (8*i);
+        }
+
+        return value;
+    }
+
+    std::string frame(std::uint32_t id, Elliptic::Server::Status status, const std::string& payload) {
+        std::string output;
+        output.reserve(Elliptic::Server::RESPONSE_HEADER + payload.length());
+        putLittleEndian(output, id, 4);
+        output += static_cast<char>(status);
+        output += static_cast<char>(payload.length());
+        return output + payload;
+    }
+
+    std::string hexToBytes(const std::string& hex) {
+        std::string bytes(hex.length() / 2, '\0');
+        for (std::size_t i = 0; i < bytes.length(); i++) {
+            bytes[i] = static_cast<char>(std::stoi(hex.substr(2*i, 2), nullptr, 16));
+        }
+
+        return bytes;
+    }
+
+    /**
+     * Nearest-rank percentile of the samples, which are reordered.
+     */
+    std::uint64_t percentile(std::vector<std::uint64_t>& samples, unsigned percent) {
+        if (samples.empty()) {
+            return 0;
+        }
+
+        std::size_t rank = std::min(samples.size() - 1, samples.size()*percent/100);
+        std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+        return samples[rank];
+    }
+
+}
+
+Elliptic::Server::Server(const Options& options)
+    : options_(options), table_(curve_, bitcoin_.getBasePoint()), stopping_(false),
+      start_(Clock::now()), requests_(0), batches_(0), errors_(0), latencies_(LATENCIES),
+      latencyCount_(0) {
+    sockaddr_un local = address(options_.path);
+    if (options_.maxBatch == 0 || options_.workers == 0 || options_.maxOutstanding == 0) {
+        throw std::invalid_argument("Batch size, workers and outstanding requests must be positive");
+    }
+
+    // A socket left behind by an earlier run is replaced, any other file is not
+    struct stat existing;
+    if (lstat(options_.path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            throw std::runtime_error("Unable to listen on " + options_.path + ": not a socket");
+        }
+
+        unlink(options_.path.c_str());
+    } else if (errno != ENOENT) {
+        throw std::runtime_error("Unable to listen on " + options_.path + ": " + std::strerror(errno));
+    }
+
+    listener_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    check(listener_, "socket");
+    if (bind(listener_, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0
+            || listen(listener_, SOMAXCONN) < 0) {
+        int error = errno;
+        close(listener_);
+        throw std::runtime_error("Unable to listen on " + options_.path + ": " + std::strerror(error));
+    }
+
+    wake_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_ < 0) {
+        int error = errno;
+        close(listener_);
+        unlink(options_.path.c_str());
+        throw std::runtime_error(std::string("eventfd: ") + std::strerror(error));
+    }
+}
+
+Elliptic::Server::~Server() {
+    close(wake_);
+    close(listener_);
+    unlink(options_.path.c_str());
+}
+
+/**
+ * Serves requests until stop() is called, which closes all connections.
+ * Batches that are already being derived when stopping are finished, requests
+ * still waiting are dropped.
+ */
+void Elliptic::Server::run() {
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    watch(epoll, EPOLL_CTL_ADD, listener_, LISTENER, EPOLLIN);
+    watch(epoll, EPOLL_CTL_ADD, wake_, WAKE, EPOLLIN);
+    watch(epoll, EPOLL_CTL_ADD, timer, TIMER, EPOLLIN);
+
+    // Batches go to the workers through `jobs` and come back through `done`,
+    // at most two per worker in flight so that waiting requests keep
+    // coalescing while the workers are busy
+    const std::size_t maxInFlight = 2*options_.workers;
+    Queue<std::vector<Request>> jobs(maxInFlight);
+    std::mutex doneMutex;
+    std::vector<std::vector<Response>> done;
+    std::vector<std::thread> workers;
+    for (unsigned w = 0; w < options_.workers; w++) {
+        workers.emplace_back([&]() {
+            std::vector<Request> batch;
+            while (jobs.pop(batch)) {
+                std::vector<Response> responses = derive(batch);
+                {
+                    std::lock_guard<std::mutex> lock(doneMutex);
+                    done.push_back(std::move(responses));
+                }
+
+                std::uint64_t one = 1;
+                ssize_t written = write(wake_, &one, sizeof(one));
+                (void) written;
+            }
+        });
+    }
+
+    std::unordered_map<std::uint64_t, Connection> connections;
+    std::uint64_t nextToken = CONNECTIONS;
+    std::vector<Request> pending;
+    std::size_t inFlight = 0;
+
+    // Room for the largest responses to maxOutstanding requests
+    const std::size_t maxOutput = options_.maxOutstanding*(RESPONSE_HEADER + 255);
+
+    auto drop = [&](std::uint64_t token) {
+        auto it = connections.find(token);
+        epoll_ctl(epoll, EPOLL_CTL_DEL, it->second.fd, nullptr);
+        close(it->second.fd);
+        connections.erase(it);
+    };
+
+    // Reads a connection only while it is below its limits, so that a client
+    // which sends faster than it reads is held back by its socket buffer.
+    // Connections that have stopped sending are dropped once fully answered.
+    auto update = [&](std::uint64_t token) {
+        Connection& connection = connections.at(token);
+        if (connection.closed && connection.outstanding == 0 && connection.output.empty()) {
+            drop(token);
+            return;
+        }
+
+        std::uint32_t events = 0;
+        if (!connection.closed && connection.outstanding < options_.maxOutstanding
+                && connection.output.length() < maxOutput) {
+            events |= EPOLLIN;
+        }
+
+        if (!connection.output.empty()) {
+            events |= EPOLLOUT;
+        }
+
+        if (events != connection.events) {
+            connection.events = events;
+            watch(epoll, EPOLL_CTL_MOD, connection.fd, token, events);
+        }
+    };
+
+    auto flush = [&](std::uint64_t token) {
+        Connection& connection = connections.at(token);
+        std::size_t sent = 0;
+        while (sent < connection.output.length()) {
+            ssize_t n = send(connection.fd, connection.output.data() + sent,
+                    connection.output.length() - sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                sent += n;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                drop(token);
+                return;
+            }
+        }
+
+        connection.output.erase(0, sent);
+        update(token);
+    };
+
+    auto respond = [&](std::uint64_t token, const std::string& frame) {
+        auto it = connections.find(token);
+        if (it != connections.end()) {
+            it->second.output += frame;
+        }
+    };
+
+    auto receive = [&](std::uint64_t token) {
+        Connection& connection = connections.at(token);
+        char buffer[1 << 16];
+
+        // No more requests than the connection may still have outstanding,
+        // the rest stays in the socket buffer
+        std::size_t limit = (options_.maxOutstanding - connection.outstanding)*REQUEST_SIZE;
+        while (connection.input.length() < limit) {
+            ssize_t n = recv(connection.fd, buffer, std::min(sizeof(buffer), limit - connection.input.length()), 0);
+            if (n > 0) {
+                connection.input.append(buffer, n);
+            } else if (n == 0) {
+                connection.closed = true; // Requests already read are still answered
+                break;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else {
+                drop(token);
+                return;
+            }
+        }
+
+        Clock::time_point now = Clock::now();
+        const std::uint8_t* input = reinterpret_cast<const std::uint8_t*>(connection.input.data());
+        std::size_t offset = 0;
+        for (; connection.input.length() - offset >= REQUEST_SIZE; offset += REQUEST_SIZE) {
+            Request request;
+            request.connection = token;
+            request.id = static_cast<std::uint32_t>(getLittleEndian(input + offset, 4));
+            request.op = input[offset + 4];
+            request.flags = input[offset + 5];
+            std::memcpy(request.key, input + offset + 6, sizeof(request.key));
+            request.arrival = now;
+
+            if (request.op == PUBLIC_KEY || request.op == ADDRESS) {
+                pending.push_back(request);
+                connection.outstanding++;
+                continue;
+            }
+
+            // Answered inline and left out of the counters, which cover key derivations
+            if (request.op == STATS) {
+                Stats current = stats();
+                std::string payload;
+                for (std::uint64_t value : { current.requests, current.batches, current.errors,
+                        current.p50, current.p99, current.microseconds }) {
+                    putLittleEndian(payload, value, 8);
+                }
+
+                respond(token, frame(request.id, OK, payload));
+            } else {
+                respond(token, frame(request.id, BAD_REQUEST, ""));
+            }
+        }
+
+        connection.input.erase(0, offset);
+        flush(token);
+    };
+
+    // Hands full batches, and the oldest requests once past the deadline, to
+    // the workers and arms the timer for the next deadline
+    auto dispatch = [&]() {
+        Clock::time_point now = Clock::now();
+        std::size_t taken = 0;
+        while (taken < pending.size() && inFlight < maxInFlight
+                && (pending.size() - taken >= options_.maxBatch
+                    || now >= pending[taken].arrival + options_.deadline)) {
+            std::size_t n = std::min(options_.maxBatch, pending.size() - taken);
+            jobs.push(std::vector<Request>(pending.begin() + taken, pending.begin() + taken + n));
+            taken += n;
+            inFlight++;
+            batches_++;
+        }
+
+        pending.erase(pending.begin(), pending.begin() + taken);
+
+        itimerspec deadline = {};
+        if (!pending.empty() && inFlight < maxInFlight) {
+            auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    pending.front().arrival + options_.deadline - now).count();
+            wait = std::max<decltype(wait)>(wait, 1);
+            deadline.it_value.tv_sec = wait / 1000000000;
+            deadline.it_value.tv_nsec = wait % 1000000000;
+        }
+
+        timerfd_settime(timer, 0, &deadline, nullptr);
+    };
+
+    std::exception_ptr error;
+    try {
+        epoll_event events[64];
+        while (!stopping_) {
+            int count = epoll_wait(epoll, events, 64, -1);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+
+            check(count, "epoll_wait");
+            for (int e = 0; e < count; e++) {
+                std::uint64_t token = events[e].data.u64;
+                if (token == LISTENER) {
+                    for (int fd; (fd = accept4(listener_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0;) {
+                        watch(epoll, EPOLL_CTL_ADD, fd, nextToken, EPOLLIN);
+                        connections[nextToken++] = { fd, "", "", 0, EPOLLIN, false };
+                    }
+                } else if (token == WAKE || token == TIMER) {
+                    std::uint64_t value;
+                    ssize_t n = read(token == WAKE ? wake_ : timer, &value, sizeof(value));
+                    (void) n;
+                } else if (connections.count(token) != 0) {
+                    // Hang up means neither direction is left, so nothing can be answered
+                    if ((events[e].events & (EPOLLHUP | EPOLLERR)) != 0) {
+                        drop(token);
+                        continue;
+                    }
+
+                    if ((events[e].events & EPOLLIN) != 0) {
+                        receive(token);
+                    }
+
+                    if ((events[e].events & EPOLLOUT) != 0 && connections.count(token) != 0) {
+                        flush(token);
+                    }
+                }
+            }
+
+            std::vector<std::vector<Response>> finished;
+            {
+                std::lock_guard<std::mutex> lock(doneMutex);
+                finished.swap(done);
+            }
+
+            std::vector<std::uint64_t> touched;
+            for (std::vector<Response>& responses : finished) {
+                inFlight--;
+                for (Response& response : responses) {
+                    auto it = connections.find(response.connection);
+                    if (it != connections.end()) {
+                        it->second.outstanding--;
+                    }
+
+                    requests_++;
+                    if (response.failed) {
+                        errors_++;
+                    }
+
+                    record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        Clock::now() - response.arrival).count());
+                    respond(response.connection, response.frame);
+                    touched.push_back(response.connection);
+                }
+            }
+
+            std::sort(touched.begin(), touched.end());
+            touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+            for (std::uint64_t token : touched) {
+                if (connections.count(token) != 0) {
+                    flush(token);
+                }
+            }
+
+            dispatch();
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    jobs.close();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    for (auto& connection : connections) {
+        close(connection.second.fd);
+    }
+
+    close(timer);
+    close(epoll);
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * Makes run() return, from any thread or a signal handler.
+ */
+void Elliptic::Server::stop() {
+    stopping_ = true;
+    std::uint64_t one = 1;
+    ssize_t written = write(wake_, &one, sizeof(one));
+    (void) written;
+}
+
+Elliptic::Server::Stats Elliptic::Server::stats() const {
+    std::vector<std::uint64_t> samples;
+    {
+        std::lock_guard<std::mutex> lock(latencyMutex_);
+        samples.assign(latencies_.begin(), latencies_.begin() + std::min(latencyCount_, LATENCIES));
+    }
+
+    Stats stats;
+    stats.requests = requests_;
+    stats.batches = batches_;
+    stats.errors = errors_;
+    stats.p50 = percentile(samples, 50);
+    stats.p99 = percentile(samples, 99);
+    stats.microseconds = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start_).count();
+    return stats;
+}
+
+/**
+ * Multiplies the valid keys of the batch with the base table in one go and
+ * encodes the responses.
+ */
+std::vector<Elliptic::Server::Response> Elliptic::Server::derive(const std::vector<Request>& batch) const {
+    mpz_class order = curve_.getOrder();
+    std::vector<mpz_class> keys;
+    std::vector<bool> valid(batch.size());
+    for (std::size_t i = 0; i < batch.size(); i++) {
+        mpz_class k;
+        mpz_import(k.get_mpz_t(), sizeof(batch[i].key), 1, 1, 0, 0, batch[i].key);
+        valid[i] = k > 0 && k < order;
+        if (valid[i]) {
+            keys.push_back(k);
+        }
+    }
+
+    std::vector<Point> points = table_.multiply(keys);
+    std::vector<Response> responses(batch.size());
+    for (std::size_t i = 0, t = 0; i < batch.size(); i++) {
+        const Request& request = batch[i];
+        responses[i].connection = request.connection;
+        responses[i].arrival = request.arrival;
+        responses[i].failed = !valid[i];
+        if (!valid[i]) {
+            responses[i].frame = frame(request.id, INVALID_KEY, "");
+            continue;
+        }
+
+        bool compressed = (request.flags & COMPRESSED) != 0;
+        const Point& p = points[t++];
+        responses[i].frame = frame(request.id, OK, request.op == ADDRESS
+                ? bitcoin_.pointToAddress(p, compressed) : hexToBytes(bitcoin_.pointToPublicKey(p, compressed)));
+    }
+
+    return responses;
+}
+
+void Elliptic::Server::record(std::uint64_t nanoseconds) {
+    std::lock_guard<std::mutex> lock(latencyMutex_);
+    latencies_[latencyCount_++ % LATENCIES] = nanoseconds;
+}
+
+Elliptic::ServerClient::ServerClient(const std::string& path) {
+    sockaddr_un remote = address(path);
+    socket_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    check(socket_, "socket");
+    if (connect(socket_, reinterpret_cast<sockaddr*>(&remote), sizeof(remote)) < 0) {
+        int error = errno;
+        close(socket_);
+        throw std::runtime_error("Unable to connect to " + path + ": " + std::strerror(error));
+    }
+}
+
+Elliptic::ServerClient::~ServerClient() {
+    close(socket_);
+}
+
+/**
+ * Sends a request without waiting for its response. privateHex is ignored
+ * for STATS.
+ */
+void Elliptic::ServerClient::send(std::uint32_t id, Server::Op op, const std::string& privateHex, bool compressed) {
+    std::uint8_t request[Server::REQUEST_SIZE] = {};
+    for (std::size_t i = 0; i < 4; i++) {
+        request[i] = static_cast<std::uint8_t>(id >> (8*i));
+    }
+
+    request[4] = op;
+    request[5] = compressed ? Server::COMPRESSED : 0;
+    if (op != Server::STATS) {
+        mpz_class k;
+        if (privateHex.length() > 64 || k.set_str(privateHex, 16) != 0) {
+            throw std::invalid_argument("Invalid private key " + privateHex);
+        }
+
+        std::size_t length = (mpz_sizeinbase(k.get_mpz_t(), 2) + 7) / 8;
+        mpz_export(request + Server::REQUEST_SIZE - length, nullptr, 1, 1, 0, 0, k.get_mpz_t());
+    }
+
+    for (std::size_t sent = 0; sent < sizeof(request);) {
+        ssize_t n = ::send(socket_, request + sent, sizeof(request) - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        check(static_cast<int>(n), "send");
+        sent += n;
+    }
+}
+
+/**
+ * Tells the server that no more requests follow. Responses to the requests
+ * already sent can still be received.
+ */
+void Elliptic::ServerClient::finish() {
+    check(shutdown(socket_, SHUT_WR), "shutdown");
+}
+
+Elliptic::ServerClient::Response Elliptic::ServerClient::receive() {
+    std::uint8_t header[Server::RESPONSE_HEADER];
+    read(header, sizeof(header));
+
+    Response response;
+    response.id = static_cast<std::uint32_t>(getLittleEndian(header, 4));
+    response.status = static_cast<Server::Status>(header[4]);
+    response.payload.resize(header[5]);
+    read(reinterpret_cast<std::uint8_t*>(&response.payload[0]), response.payload.length());
+    return response;
+}
+
+/**
+ * Queries the server counters. Responses to requests still in flight on this
+ * connection are discarded.
+ */
+Elliptic::Server::Stats Elliptic::ServerClient::stats() {
+    const std::uint32_t id = 0xFFFFFFFF;
+    send(id, Server::STATS);
+
+    Response response;
+    do {
+        response = receive();
+    } while (response.id != id);
+
+    if (response.status != Server::OK || response.payload.length() != 6*8) {
+        throw std::runtime_error("Invalid STATS response");
+    }
+
+    const std::uint8_t* payload = reinterpret_cast<const std::uint8_t*>(response.payload.data());
+    Server::Stats stats;
+    std::uint64_t* fields[] = { &stats.requests, &stats.batches, &stats.errors, &stats.p50, &stats.p99,
+        &stats.microseconds };
+    for (std::size_t i = 0; i < 6; i++) {
+        *fields[i] = getLittleEndian(payload + 8*i, 8);
+    }
+
+    return stats;
+}
+
+/**
+ * Load generator: `connections` clients, each on its own thread, send their
+ * share of `requests` random keys keeping up to `depth` requests in flight.
+ */
+Elliptic::ServerClient::Report Elliptic::ServerClient::load(const std::string& path, unsigned connections,
+        std::uint64_t requests, std::size_t depth, Server::Op op) {
+    connections = std::max(1u, connections);
+    depth = std::max<std::size_t>(1, depth);
+    std::vector<std::string> keys = Bitcoin().generatePrivateHex(1024);
+
+    std::vector<std::unique_ptr<ServerClient>> clients;
+    for (unsigned c = 0; c < connections; c++) {
+        clients.emplace_back(new ServerClient(path));
+    }
+
+    std::vector<std::vector<std::uint64_t>> latencies(connections);
+    std::vector<std::uint64_t> errors(connections, 0);
+    Clock::time_point start = Clock::now();
+
+    Parallel::forEach(connections, [&](std::size_t c) {
+        std::uint64_t total = requests / connections + (c < requests % connections ? 1 : 0);
+        std::vector<Clock::time_point> sent(total);
+        latencies[c].reserve(total);
+
+        std::uint64_t next = 0;
+        for (std::uint64_t received = 0; received < total; received++) {
+            for (; next < total && next - received < depth; next++) {
+                sent[next] = Clock::now();
+                clients[c]->send(static_cast<std::uint32_t>(next), op, keys[(c + next) % keys.size()]);
+            }
+
+            Response response = clients[c]->receive();
+            if (response.id >= next) {
+                throw std::runtime_error("Unexpected response id " + std::to_string(response.id));
+            }
+
+            latencies[c].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now() - sent[response.id]).count());
+            if (response.status != Server::OK) {
+                errors[c]++;
+            }
+        }
+    }, connections);
+
+    Report report;
+    report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<std::uint64_t> samples;
+    report.errors = 0;
+    for (unsigned c = 0; c < connections; c++) {
+        samples.insert(samples.end(), latencies[c].begin(), latencies[c].end());
+        report.errors += errors[c];
+    }
+
+    report.requests = samples.size();
+    report.p50 = percentile(samples, 50);
+    report.p99 = percentile(samples, 99);
+    return report;
+}
+
+void Elliptic::ServerClient::read(std::uint8_t* buffer, std::size_t length) {
+    for (std::size_t received = 0; received < length;) {
+        ssize_t n = recv(socket_, buffer + received, length - received, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (n <= 0) {
+            throw std::runtime_error("Connection to server closed");
+        }
+
+        received += n;
+    }
+}
@@ -0,0 +1,598 @@
+#include "simd.h"
+
+#include <algorithm> // std::max
+#include <stdexcept> // std::invalid_argument
+
+#include <immintrin.h>
+
+#include "instrument.h"
+
+namespace {
+
+    typedef std::uint64_t Limb;
+
+    const Limb MASK52 = (Limb(1) << 52) - 1;
+    const Limb MASK26 = (Limb(1) << 26) - 1;
+
+    /**
+     * Portable fallback in radix 2^52 with the same limb layout as IFMA,
+     * emulating its 52-bit low and high product halves with 128-bit integers.
+     */
+    void carryScalar(Limb* t) {
+        for (int j = 0; j < 4; j++) {
+            t[j + 1] += static_cast<Limb>(static_cast<std::int64_t>(t[j]) >> 52);
+            t[j] &= MASK52;
+        }
+    }
+
+    // t < 2p with carried limbs becomes t mod p
+    void reduceScalar(Limb* t, const Limb* p) {
+        Limb d[5];
+        for (int j = 0; j < 5; j++) {
+            d[j] = t[j] - p[j];
+        }
+
+        carryScalar(d);
+        Limb keep = -(d[4] >> 63); // All ones if t < p
+        for (int j = 0; j < 5; j++) {
+            t[j] = (t[j] & keep) | (d[j] & ~keep);
+        }
+    }
+
+    void multiplyScalar(Limb* r, const Limb* a, const Limb* b, std::size_t stride, std::size_t bStride,
+            bool bAdvance, std::size_t count, const Limb* p, Limb inv) {
+        for (std::size_t e = 0; e < count; e++) {
+            const Limb* y = b + (bAdvance ? e : 0);
+            Limb x[5], t[6] = {};
+            for (int j = 0; j < 5; j++) {
+                x[j] = a[j*stride + e];
+            }
+
+            for (int i = 0; i < 5; i++) {
+                Limb bi = y[i*bStride];
+                for (int j = 0; j < 5; j++) {
+                    unsigned __int128 product = static_cast<unsigned __int128>(x[j])*bi;
+                    t[j] += static_cast<Limb>(product) & MASK52;
+                    t[j + 1] += static_cast<Limb>(product >> 52);
+                }
+
+                Limb m = t[0]*inv & MASK52;
+                for (int j = 0; j < 5; j++) {
+                    unsigned __int128 product = static_cast<unsigned __int128>(m)*p[j];
+                    t[j] += static_cast<Limb>(product) & MASK52;
+                    t[j + 1] += static_cast<Limb>(product >> 52);
+                }
+
+                t[1] += t[0] >> 52;
+                for (int j = 0; j < 5; j++) {
+                    t[j] = t[j + 1];
+                }
+                t[5] = 0;
+            }
+
+            carryScalar(t);
+            reduceScalar(t, p);
+            for (int j = 0; j < 5; j++) {
+                r[j*stride + e] = t[j];
+            }
+        }
+    }
+
+    // negate selects a - b + p instead of a + b, both in (0, 2p)
+    void sumScalar(Limb* r, const Limb* a, const Limb* b, std::size_t stride, std::size_t count,
+            const Limb* p, bool negate) {
+        for (std::size_t e = 0; e < count; e++) {
+            Limb t[5];
+            for (int j = 0; j < 5; j++) {
+                t[j] = negate ? a[j*stride + e] - b[j*stride + e] + p[j] : a[j*stride + e] + b[j*stride + e];
+            }
+
+            carryScalar(t);
+            reduceScalar(t, p);
+            for (int j = 0; j < 5; j++) {
+                r[j*stride + e] = t[j];
+            }
+        }
+    }
+
+    void addScalar(Limb* r, const Limb* a, const Limb* b, std::size_t stride, std::size_t count, const Limb* p) {
+        sumScalar(r, a, b, stride, count, p, false);
+    }
+
+    void subtractScalar(Limb* r, const Limb* a, const Limb* b, std::size_t stride, std::size_t count,
+            const Limb* p) {
+        sumScalar(r, a, b, stride, count, p, true);
+    }
+
+    /**
+     * AVX2: four elements per register in radix 2^26, so that vpmuludq's
+     * 32x32-bit products of two limbs accumulate in 64-bit lanes without
+     * splitting. AVX2 lacks a 64-bit arithmetic shift; limbs stay far from
+     * 2^62, so a biased logical shift stands in for it.
+     */
+    __attribute__((target("avx2")))
+    inline __m256i shiftAvx2(__m256i t) {
+        const __m256i bias = _mm256_set1_epi64x(std::int64_t(1) << 62);
+        return _mm256_sub_epi64(_mm256_srli_epi64(_mm256_add_epi64(t, bias), 26),
+            _mm256_set1_epi64x(std::int64_t(1) << 36));
+    }
+
+    __attribute__((target("avx2")))
+    inline void carryAvx2(__m256i* t) {
+        const __m256i mask = _mm256_set1_epi64x(MASK26);
+        #pragma GCC unroll 10
+        for (int j = 0; j < 9; j++) {
+            t[j + 1] = _mm256_add_epi64(t[j + 1], shiftAvx2(t[j]));
+            t[j] = _mm256_and_si256(t[j], mask);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    inline void reduceAvx2(__m256i* t, const __m256i* p) {
+        __m256i d[10];
+        #pragma GCC unroll 10
+        for (int j = 0; j < 10; j++) {
+            d[j] = _mm256_sub_epi64(t[j], p[j]);
+        }
+
+        carryAvx2(d);
+        __m256i keep = _mm256_cmpgt_epi64(_mm256_setzero_si256(), d[9]);
+        #pragma GCC unroll 10
+        for (int j = 0; j < 10; j++) {
+            t[j] = _mm256_blendv_epi8(d[j], t[j], keep);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void multiplyAvx2(Limb* r, const Limb* a, const Limb* b, std::size_t stride, std::size_t bStride,
+            bool bAdvance, std::size_t count, const Limb* prime, Limb inv) {
+        const __m256i zero = _mm256_setzero_si256(), mask = _mm256_set1_epi64x(MASK26);
+        const __m256i n = _mm256_set1_epi64x(inv);
+        __m256i p[10];
+        for (int j = 0; j < 10; j++) {
+            p[j] = _mm256_set1_epi64x(prime[j]);
+        }
+
+        for (std::size_t e = 0; e < count; e += 4) {
+            const Limb* y = b + (bAdvance ? e : 0);
+            __m256i x[10], t[10];
+            #pragma GCC unroll 10
+            for (int j = 0; j < 10; j++) {
+                x[j] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + j*stride + e));
+                t[j] = zero;
+            }
+
+            #pragma GCC unroll 10
+            for (int i = 0; i < 10; i++) {
+                __m256i bi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i*bStride));
+                #pragma GCC unroll 10
+                for (int j = 0; j < 10; j++) {
+                    t[j] = _mm256_add_epi64(t[j], _mm256_mul_epu32(x[j], bi));
+                }
+
+                __m256i m = _mm256_and_si256(_mm256_mul_epu32(t[0], n), mask);
+                #pragma GCC unroll 10
+                for (int j = 0; j < 10; j++) {
+                    t[j] = _mm256_add_epi64(t[j], _mm256_mul_epu32(m, p[j]));
+                }
+
+                t[1] = _mm256_add_epi64(t[1], _mm256_srli_epi64(t[0], 26));
+                #pragma GCC unroll 10
+                for (int j = 0; j < 9; j++) {
+                    t[j] = t[j + 1];
+                }
+                t[9] = zero;
+            }
+
+            carryAvx2(t);
+            reduceAvx2(t, p);
+            #pragma GCC unroll 10
+            for (int j = 0; j < 10; j++) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + j*stride + e), t[j]);
+            }
+        }
+    }
+
+    __attribute__((target("avx2")))
+    inline void sumAvx2(Limb* r, const Limb* a, const Limb* b, std::size_t stride, std::size_t count,
+            const Limb* prime, bool negate) {
+        __m256i p[10];
+        for (int j = 0; j < 10; j++) {
+            p[j] = _mm256_set1_epi64x(prime[j]);
+        }
+
+        for (std::size_t e = 0; e < count; e += 4) {
+            __m256i t[10];
+            #pragma GCC unroll 10
+            for (int j = 0; j < 10; j++) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + j*stride + e));
+                __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j*stride + e));
+                t[j] = negate ? _mm256_add_epi64(_mm256_sub_epi64(x, y), p[j]) : _mm256_add_epi64(x, y);
+            }
+
+            carryAvx2(t);
+            reduceAvx2(t, p);
+            #pragma GCC unroll 10
+            for (int j = 0; j < 10; j++) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + j*stride + e), t[j]);
+            }
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void addAvx2(Limb* r, const Limb* a, const Limb* b, std::size_t stride, std::size_t count, const Limb* p) {
+        sumAvx2(r, a, b, stride, count, p, false);
+    }
+
+    __attribute__((target("avx2")))
+    void subtractAvx2(Limb* r, const Limb* a, const Limb* b, std::size_t stride, std::size_t count,
+            const Limb* p) {
+        sumAvx2(r, a, b, stride, count, p, true);
+    }
+
+    // GCC 12 flags the undefined pass-through operand inside its AVX-512 shift intrinsics
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+    /**
+     * AVX-512 IFMA: eight elements per register in radix 2^52. vpmadd52luq
+     * and vpmadd52huq add the low and high 52 bits of a 52x52-bit product to
+     * a 64-bit accumulator, so the high half goes one limb up.
+     */
+    __attribute__((target("avx512f,avx512ifma")))
+    inline void carryIfma(__m512i* t) {
+        const __m512i mask = _mm512_set1_epi64(MASK52);
+        #pragma GCC unroll 5
+        for (int j = 0; j < 4; j++) {
+            t[j + 1] = _mm512_add_epi64(t[j + 1], _mm512_srai_epi64(t[j], 52));
+            t[j] = _mm512_and_si512(t[j], mask);
+        }
+    }
+
+    __attribute__((target("avx512f,avx512ifma")))
+    inline void reduceIfma(__m512i* t, const __m512i* p) {
+        __m512i d[5];
+        #pragma GCC unroll 5
+        for (int j = 0; j < 5; j++) {
+            d[j] = _mm512_sub_epi64(t[j], p[j]);
+        }
+
+        carryIfma(d);
+        __mmask8 keep = _mm512_cmplt_epi64_mask(d[4], _mm512_setzero_si512());
+        #pragma GCC unroll 5
+        for (int j = 0; j < 5; j++) {
+            t[j] = _mm512_mask_blend_epi64(keep, d[j], t[j]);
+        }
+    }
+
+    __attribute__((target("avx512f,avx512ifma")))
+    void multiplyIfma(Limb* r, const Limb* a, const Limb* b, std::size_t stride, std::size_t bStride,
+            bool bAdvance, std::size_t count, const Limb* prime, Limb inv) {
+        const __m512i zero = _mm512_setzero_si512(), n = _mm512_set1_epi64(inv);
+        __m512i p[5];
+        for (int j = 0; j < 5; j++) {
+            p[j] = _mm512_set1_epi64(prime[j]);
+        }
+
+        for (std::size_t e = 0; e < count; e += 8) {
+            const Limb* y = b + (bAdvance ? e : 0);
+            __m512i x[5], t[6];
+            #pragma GCC unroll 5
+            for (int j = 0; j < 5; j++) {
+                x[j] = _mm512_loadu_si512(a + j*stride + e);
+                t[j] = zero;
+            }
+            t[5] = zero;
+
+            #pragma GCC unroll 5
+            for (int i = 0; i < 5; i++) {
+                __m512i bi = _mm512_loadu_si512(y + i*bStride);
+                #pragma GCC unroll 5
+                for (int j = 0; j < 5; j++) {
+                    t[j] = _mm512_madd52lo_epu64(t[j], x[j], bi);
+                    t[j + 1] = _mm512_madd52hi_epu64(t[j + 1], x[j], bi);
+                }
+
+                __m512i m = _mm512_madd52lo_epu64(zero, t[0], n);
+                #pragma GCC unroll 5
+                for (int j = 0; j < 5; j++) {
+                    t[j] = _mm512_madd52lo_epu64(t[j], m, p[j]);
+                    t[j + 1] = _mm512_madd52hi_epu64(t[j + 1], m, p[j]);
+                }
+
+                t[1] = _mm512_add_epi64(t[1], _mm512_srli_epi64(t[0], 52));
+                #pragma GCC unroll 5
+                for (int j = 0; j < 5; j++) {
+                    t[j] = t[j + 1];
+                }
+                t[5] = zero;
+            }
+
+            carryIfma(t);
+            reduceIfma(t, p);
+            #pragma GCC unroll 5
+            for (int j = 0; j < 5; j++) {
+                _mm512_storeu_si512(r + j*stride + e, t[j]);
+            }
+        }
+    }
+
+    __attribute__((target("avx512f,avx512ifma")))
+    inline void sumIfma(Limb* r, const Limb* a, const Limb* b, std::size_t stride, std::size_t count,
+            const Limb* prime, bool negate) {
+        __m512i p[5];
+        for (int j = 0; j < 5; j++) {
+            p[j] = _mm512_set1_epi64(prime[j]);
+        }
+
+        for (std::size_t e = 0; e < count; e += 8) {
+            __m512i t[5];
+            #pragma GCC unroll 5
+            for (int j = 0; j < 5; j++) {
+                __m512i x = _mm512_loadu_si512(a + j*stride + e), y = _mm512_loadu_si512(b + j*stride + e);
+                t[j] = negate ? _mm512_add_epi64(_mm512_sub_epi64(x, y), p[j]) : _mm512_add_epi64(x, y);
+            }
+
+            carryIfma(t);
+            reduceIfma(t, p);
+            #pragma GCC unroll 5
+            for (int j = 0; j < 5; j++) {
+                _mm512_storeu_si512(r + j*stride + e, t[j]);
+            }
+        }
+    }
+
+    __attribute__((target("avx512f,avx512ifma")))
+    void addIfma(Limb* r, const Limb* a, const Limb* b, std::size_t stride, std::size_t count, const Limb* p) {
+        sumIfma(r, a, b, stride, count, p, false);
+    }
+
+    __attribute__((target("avx512f,avx512ifma")))
+    void subtractIfma(Limb* r, const Limb* a, const Limb* b, std::size_t stride, std::size_t count,
+            const Limb* p) {
+        sumIfma(r, a, b, stride, count, p, true);
+    }
+
+    #pragma GCC diagnostic pop
+
+    // Limbs of an integer below 2^256 given as VectorField::WORDS words
+    void split(Limb* limbs, std::size_t stride, const Limb* words, unsigned radix, std::size_t count) {
+        const Limb mask = (Limb(1) << radix) - 1;
+        for (std::size_t j = 0; j < count; j++) {
+            std::size_t bit = j*radix, w = bit/64, s = bit % 64;
+            Limb value = words[w] >> s;
+            if (s + radix > 64 && w + 1 < Elliptic::VectorField::WORDS) {
+                value |= words[w + 1] << (64 - s);
+            }
+
+            limbs[j*stride] = value & mask;
+        }
+    }
+
+    void join(Limb* words, const Limb* limbs, std::size_t stride, unsigned radix, std::size_t count) {
+        for (int w = 0; w < Elliptic::VectorField::WORDS; w++) {
+            words[w] = 0;
+        }
+
+        for (std::size_t j = 0; j < count; j++) {
+            std::size_t bit = j*radix, w = bit/64, s = bit % 64;
+            words[w] |= limbs[j*stride] << s;
+            if (s + radix > 64 && w + 1 < Elliptic::VectorField::WORDS) {
+                words[w + 1] |= limbs[j*stride] >> (64 - s);
+            }
+        }
+    }
+
+}
+
+struct Elliptic::VectorField::Kernel {
+    std::size_t lanes, limbs;
+    unsigned radix;
+    void (*multiply)(Limb* r, const Limb* a, const Limb* b, std::size_t stride, std::size_t bStride,
+        bool bAdvance, std::size_t count, const Limb* p, Limb inv);
+    void (*add)(Limb* r, const Limb* a, const Limb* b, std::size_t stride, std::size_t count, const Limb* p);
+    void (*subtract)(Limb* r, const Limb* a, const Limb* b, std::size_t stride, std::size_t count,
+        const Limb* p);
+};
+
+namespace {
+
+    // Indexed by VectorField::Level
+    const Elliptic::VectorField::Kernel KERNELS[] = {
+        { 1, 5, 52, multiplyScalar, addScalar, subtractScalar },
+        { 4, 10, 26, multiplyAvx2, addAvx2, subtractAvx2 },
+        { 8, 5, 52, multiplyIfma, addIfma, subtractIfma }
+    };
+
+}
+
+const std::size_t Elliptic::VectorField::ROW;
+
+Elliptic::VectorField::Level Elliptic::VectorField::best() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma")) {
+        return AVX512_IFMA;
+    }
+
+    return __builtin_cpu_supports("avx2") ? AVX2 : SCALAR;
+}
+
+Elliptic::VectorField::VectorField(const mpz_class& prime, Level level) : level_(level), prime_(prime) {
+    if (sgn(prime) <= 0 || mpz_even_p(prime.get_mpz_t()) || mpz_sizeinbase(prime.get_mpz_t(), 2) > 64*WORDS) {
+        throw std::invalid_argument("VectorField requires an odd prime of at most 256 bits");
+    }
+
+    if (level < SCALAR || level > best()) {
+        throw std::invalid_argument("SIMD level is not supported by this CPU");
+    }
+
+    kernel_ = &KERNELS[level];
+    lanes_ = kernel_->lanes;
+    limbs_ = kernel_->limbs;
+    radix_ = kernel_->radix;
+
+    Limb words[WORDS] = {};
+    mpz_export(words, nullptr, -1, sizeof(Limb), 0, 0, prime.get_mpz_t());
+    p_.resize(limbs_);
+    split(p_.data(), 1, words, radix_, limbs_);
+
+    // Newton iteration for p^-1 mod 2^64, truncated to the radix
+    Limb inv = 1;
+    for (int i = 0; i < 6; i++) {
+        inv *= 2 - words[0]*inv;
+    }
+    inv_ = -inv & ((Limb(1) << radix_) - 1);
+
+    mpz_class R;
+    mpz_setbit(R.get_mpz_t(), radix_*limbs_);
+    one_ = vector(ROW);
+    unit_ = vector(ROW);
+    r2_ = vector(ROW);
+    for (std::size_t e = 0; e < ROW; e++) {
+        pack(one_, e, R % prime);
+        pack(unit_, e, 1);
+        pack(r2_, e, R*R % prime);
+    }
+}
+
+Elliptic::VectorField::Vector Elliptic::VectorField::vector(std::size_t count) const {
+    Vector v;
+    v.count_ = count;
+    v.stride_ = std::max(ROW, (count + ROW - 1)/ROW*ROW);
+    v.data_.assign(limbs_*v.stride_, 0);
+    return v;
+}
+
+void Elliptic::VectorField::fromWords(Vector& r, const std::uint64_t* words) const {
+    for (std::size_t e = 0; e < r.count_; e++) {
+        split(&r.data_[e], r.stride_, words + e*WORDS, radix_, limbs_);
+    }
+
+    multiply(r.data_.data(), r.data_.data(), r2_.data_.data(), r.stride_, ROW, false, r.stride_);
+}
+
+void Elliptic::VectorField::toWords(std::uint64_t* words, const Vector& a) const {
+    Vector t = vector(a.count_);
+    multiply(t.data_.data(), a.data_.data(), unit_.data_.data(), a.stride_, ROW, false, a.stride_);
+    for (std::size_t e = 0; e < a.count_; e++) {
+        join(words + e*WORDS, &t.data_[e], t.stride_, radix_, limbs_);
+    }
+}
+
+void Elliptic::VectorField::add(Vector& r, const Vector& a, const Vector& b) const {
+    shape(r, a, b);
+    kernel_->add(r.data_.data(), a.data_.data(), b.data_.data(), a.stride_, a.stride_, p_.data());
+}
+
+void Elliptic::VectorField::subtract(Vector& r, const Vector& a, const Vector& b) const {
+    shape(r, a, b);
+    kernel_->subtract(r.data_.data(), a.data_.data(), b.data_.data(), a.stride_, a.stride_, p_.data());
+}
+
+void Elliptic::VectorField::multiply(Vector& r, const Vector& a, const Vector& b) const {
+    shape(r, a, b);
+    ELLIPTIC_COUNT_N(FIELD_MULTIPLICATIONS, r.size());
+    multiply(r.data_.data(), a.data_.data(), b.data_.data(), a.stride_, a.stride_, true, a.stride_);
+}
+
+/**
+ * Montgomery's trick down each of the ROW columns of the array: prefix
+ * products row by row, one inversion of the last row's ROW products, then
+ * back again. Zero elements (and the padding) stand in as one so they do not
+ * spoil their column, and invert to zero.
+ */
+void Elliptic::VectorField::inverse(Vector& r, const Vector& a) const {
+    std::size_t stride = a.stride_, rows = stride/ROW;
+    Vector values = a, prefix = vector(a.count_);
+    std::vector<bool> zero(stride);
+    for (std::size_t e = 0; e < stride; e++) {
+        Limb bits = 0;
+        for (std::size_t j = 0; j < limbs_; j++) {
+            bits |= values.data_[j*stride + e];
+        }
+
+        if (e >= a.count_ || bits == 0) {
+            zero[e] = true;
+            for (std::size_t j = 0; j < limbs_; j++) {
+                values.data_[j*stride + e] = one_.data_[j*ROW];
+            }
+        }
+    }
+
+    for (std::size_t j = 0; j < limbs_; j++) {
+        for (std::size_t e = 0; e < ROW; e++) {
+            prefix.data_[j*stride + e] = values.data_[j*stride + e];
+        }
+    }
+
+    for (std::size_t k = 1; k < rows; k++) {
+        multiply(&prefix.data_[k*ROW], &prefix.data_[(k - 1)*ROW], &values.data_[k*ROW], stride, stride,
+            true, ROW);
+    }
+
+    // The last row holds x_l R for the column products x_l; x_l^-1 R = R^2 (x_l R)^-1
+    mpz_class columns[ROW], product = 1, r2 = unpack(r2_, 0);
+    for (std::size_t l = 0; l < ROW; l++) {
+        columns[l] = product;
+        product = product*unpack(prefix, (rows - 1)*ROW + l) % prime_;
+    }
+
+    mpz_class inv;
+    mpz_invert(inv.get_mpz_t(), product.get_mpz_t(), prime_.get_mpz_t());
+    Vector row = vector(ROW);
+    for (std::size_t l = ROW; l-- > 0;) {
+        mpz_class x = unpack(prefix, (rows - 1)*ROW + l);
+        pack(row, l, inv*columns[l] % prime_*r2 % prime_);
+        inv = inv*x % prime_;
+    }
+
+    shape(r, a, a);
+    for (std::size_t k = rows; k-- > 1;) {
+        multiply(&r.data_[k*ROW], &prefix.data_[(k - 1)*ROW], row.data_.data(), stride, ROW, true, ROW);
+        multiply(row.data_.data(), row.data_.data(), &values.data_[k*ROW], ROW, stride, true, ROW);
+    }
+
+    for (std::size_t j = 0; j < limbs_; j++) {
+        for (std::size_t e = 0; e < ROW; e++) {
+            r.data_[j*stride + e] = row.data_[j*ROW + e];
+        }
+    }
+
+    for (std::size_t e = 0; e < stride; e++) {
+        if (zero[e]) {
+            for (std::size_t j = 0; j < limbs_; j++) {
+                r.data_[j*stride + e] = 0;
+            }
+        }
+    }
+}
+
+void Elliptic::VectorField::multiply(std::uint64_t* r, const std::uint64_t* a, const std::uint64_t* b,
+        std::size_t stride, std::size_t bStride, bool bAdvance, std::size_t count) const {
+    kernel_->multiply(r, a, b, stride, bStride, bAdvance, count, p_.data(), inv_);
+}
+
+void Elliptic::VectorField::shape(Vector& r, const Vector& a, const Vector& b) const {
+    if (a.count_ != b.count_) {
+        throw std::invalid_argument("Vectors must have the same size");
+    }
+
+    if (r.count_ != a.count_ || r.data_.size() != a.data_.size()) {
+        r = vector(a.count_);
+    }
+}
+
+void Elliptic::VectorField::pack(Vector& r, std::size_t e, const mpz_class& op) const {
+    Limb words[WORDS] = {};
+    mpz_export(words, nullptr, -1, sizeof(Limb), 0, 0, op.get_mpz_t());
+    split(&r.data_[e], r.stride_, words, radix_, limbs_);
+}
+
+mpz_class Elliptic::VectorField::unpack(const Vector& a, std::size_t e) const {
+    Limb words[WORDS];
+    join(words, &a.data_[e], a.stride_, radix_, limbs_);
+
+    mpz_class op;
+    mpz_import(op.get_mpz_t(), WORDS, -1, sizeof(Limb), 0, 0, words);
+    return op;
+}
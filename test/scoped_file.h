@@ -0,0 +1,33 @@
+#ifndef SCOPED_FILE_H
+#define SCOPED_FILE_H
+
+#include <cstdio>   // std::remove
+#include <string>   // std::string
+#include <unistd.h> // mkstemp, close
+
+#include <boost/test/unit_test.hpp>
+
+/**
+ * Removes the file at the path when it goes out of scope, so failed
+ * assertions do not leave files behind.
+ */
+struct ScopedFile {
+    std::string path;
+
+    explicit ScopedFile(const std::string& path) : path(path) {}
+    ScopedFile(const ScopedFile&) = delete;
+    ~ScopedFile() { std::remove(path.c_str()); }
+
+    /**
+     * A new empty file under /tmp.
+     */
+    static ScopedFile temporary() {
+        char name[] = "/tmp/elliptic_test_XXXXXX";
+        int fd = mkstemp(name);
+        BOOST_REQUIRE(fd >= 0);
+        close(fd);
+        return ScopedFile(name);
+    }
+};
+
+#endif
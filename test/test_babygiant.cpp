@@ -1,8 +1,16 @@
 #include <boost/test/unit_test.hpp>
 
-#include <memory> // std::unique_ptr
+#include <algorithm> // std::sort
+#include <cstdint>   // std::uint64_t
+#include <cstdio>    // std::remove
+#include <cstring>   // std::memcpy
+#include <fstream>   // std::ofstream
+#include <memory>    // std::unique_ptr
+#include <vector>    // std::vector
 
 #include "babygiant.h"
+#include "babysteptable.h"
+#include "scoped_file.h"
 
 using namespace Elliptic;
 
@@ -28,5 +36,114 @@ BOOST_AUTO_TEST_CASE(logarithm_identity) {
     BOOST_CHECK_EQUAL(k, 1);
 }
 
+BOOST_AUTO_TEST_CASE(logarithm_multiple) {
+    Curve curve(0, 7, 37);
+    std::vector<Point> P;
+    for (int k = 1; k < 39; k++) {
+        P.push_back(curve.multiply(G, k));
+    }
+
+    std::vector<mpz_class> k = babygiant.discreteLogarithm(G, P);
+    for (std::size_t i = 0; i < k.size(); i++) {
+        BOOST_CHECK_EQUAL(k[i], i + 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(logarithm_smooth_order) {
+    // Order 168 = 2^3 * 3 * 7
+    Curve curve(0, 2, 167);
+    BabyGiant smooth(std::unique_ptr<Curve>(new Curve(0, 2, 167)));
+
+    Point H(1, 62);
+    std::vector<Point> P;
+    for (int k = 1; k < 168; k++) {
+        P.push_back(curve.multiply(H, k));
+    }
+
+    std::vector<mpz_class> k = smooth.discreteLogarithm(H, P);
+    for (std::size_t i = 0; i < k.size(); i++) {
+        BOOST_CHECK_EQUAL(k[i], i + 1);
+    }
+
+    // G = 2H has order 84, with a smaller power of 2 than the curve order
+    Point G = curve.multiply(H, 2);
+    for (int e : { 1, 5, 7, 83 }) {
+        BOOST_CHECK_EQUAL(smooth.discreteLogarithm(G, curve.multiply(G, e)), e);
+    }
+
+    // Every target is delivered exactly once
+    std::vector<std::size_t> delivered;
+    smooth.discreteLogarithm(G, { curve.multiply(G, 3), curve.multiply(G, 40) },
+            [&delivered](std::size_t t, const mpz_class&) { delivered.push_back(t); });
+    std::sort(delivered.begin(), delivered.end());
+    BOOST_CHECK(delivered == std::vector<std::size_t>({ 0, 1 }));
+}
+
+BOOST_AUTO_TEST_CASE(logarithm_partial) {
+    // G = 8H has order 21 in the group of order 168, H is not a multiple of it
+    Curve curve(0, 2, 167);
+    BabyGiant smooth(std::unique_ptr<Curve>(new Curve(0, 2, 167)));
+    Point H(1, 62), G = curve.multiply(H, 8);
+
+    std::vector<Point> P = { curve.multiply(G, 3), H, curve.multiply(G, 5) };
+    std::vector<mpz_class> k = smooth.discreteLogarithm(G, P);
+    BOOST_REQUIRE_EQUAL(k.size(), 3);
+    BOOST_CHECK_EQUAL(k[0], 3);
+    BOOST_CHECK_EQUAL(k[1], -1);
+    BOOST_CHECK_EQUAL(k[2], 5);
+
+    std::vector<std::size_t> unresolved = smooth.discreteLogarithm(G, { H, G },
+            [](std::size_t, const mpz_class&) {});
+    BOOST_CHECK(unresolved == std::vector<std::size_t>(1, 0));
+    BOOST_CHECK_THROW(smooth.discreteLogarithm(G, H), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(logarithm_saved_table) {
+    const char* path = "test_babygiant.table";
+    babygiant.saveTable(G, path);
+
+    BabyGiant other(std::unique_ptr<Curve>(new Curve(0, 7, 37)));
+    other.loadTable(path);
+    std::remove(path); // The mapping stays valid after unlinking
+
+    mpz_class k = other.discreteLogarithm(G, Point(9, 25));
+    BOOST_CHECK_EQUAL(k, 17);
+
+    BabyGiant wrongCurve(std::unique_ptr<Curve>(new Curve(0, 5, 37)));
+    babygiant.saveTable(G, path);
+    BOOST_CHECK_THROW(wrongCurve.loadTable(path), std::invalid_argument);
+    std::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(logarithm_resaved_table) {
+    // Saving the mapped table over its own file must not truncate the mapping
+    ScopedFile file = ScopedFile::temporary();
+    babygiant.saveTable(G, file.path);
+
+    BabyGiant other(std::unique_ptr<Curve>(new Curve(0, 7, 37)));
+    other.loadTable(file.path);
+    other.saveTable(G, file.path);
+    BOOST_CHECK_EQUAL(other.discreteLogarithm(G, Point(9, 25)), 17);
+
+    BabyGiant reloaded(std::unique_ptr<Curve>(new Curve(0, 7, 37)));
+    reloaded.loadTable(file.path);
+    BOOST_CHECK_EQUAL(reloaded.discreteLogarithm(G, Point(9, 25)), 17);
+}
+
+BOOST_AUTO_TEST_CASE(logarithm_crafted_table) {
+    // A count of 2^60 entries wraps count * 16 bytes around to zero
+    const char* path = "test_babygiant_crafted.table";
+    {
+        std::ofstream out(path, std::ios::binary);
+        std::uint64_t header[3] = { 0, 1, std::uint64_t(1) << 60 };
+        std::memcpy(header, "EBSGTBL1", 8);
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write("x\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", 16);
+    }
+
+    BOOST_CHECK_THROW(BabyStepTable table(path), std::runtime_error);
+    std::remove(path);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
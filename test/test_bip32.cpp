@@ -0,0 +1,72 @@
+#include <boost/test/unit_test.hpp>
+
+#include "bip32.h"
+
+using namespace Elliptic;
+
+// BIP32 test vector 1
+static const std::string SEED = "000102030405060708090A0B0C0D0E0F";
+
+BOOST_AUTO_TEST_SUITE(bip32)
+
+BOOST_AUTO_TEST_CASE(test_vector) {
+    Bip32 bip32;
+    ExtendedKey m = bip32.master(SEED);
+    BOOST_CHECK_EQUAL(bip32.serialize(m),
+        "xprv9s21ZrQH143K3QTDL4LXw2F7HEK3wJUD2nW2nRk4stbPy6cq3jPPqjiChkVvvNKmPGJxWUtg6LnF5kejMRNNU3TGtRBeJgk33yuGBxrMPHi");
+    BOOST_CHECK_EQUAL(bip32.serialize(bip32.neuter(m)),
+        "xpub661MyMwAqRbcFtXgS5sYJABqqG9YLmC4Q1Rdap9gSE8NqtwybGhePY2gZ29ESFjqJoCu1Rupje8YtGqsefD265TMg7usUDFdp6W1EGMcet8");
+
+    ExtendedKey child = bip32.derive(m, "m/0'/1");
+    BOOST_CHECK_EQUAL(bip32.serialize(child),
+        "xprv9wTYmMFdV23N2TdNG573QoEsfRrWKQgWeibmLntzniatZvR9BmLnvSxqu53Kw1UmYPxLgboyZQaXwTCg8MSY3H2EU4pWcQDnRnrVA1xe8fs");
+    BOOST_CHECK_EQUAL(bip32.serialize(bip32.neuter(child)),
+        "xpub6ASuArnXKPbfEwhqN6e3mwBcDTgzisQN1wXN9BJcM47sSikHjJf3UFHKkNAWbWMiGj7Wf5uMash7SyYq527Hqck2AxYysAA7xmALppuCkwQ");
+
+    // Served from the cache the second time
+    BOOST_CHECK_EQUAL(bip32.getCacheHits(), 0);
+    BOOST_CHECK_EQUAL(bip32.serialize(bip32.derive(m, "m/0h/1")), bip32.serialize(child));
+    BOOST_CHECK_EQUAL(bip32.getCacheHits(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(cache_per_root) {
+    Bip32 bip32;
+    ExtendedKey m = bip32.master(SEED);
+    ExtendedKey child = bip32.derive(m, "m/0'/1");
+
+    // A different key with the same chain code must not hit the cache of m
+    ExtendedKey other = bip32.derive(m, 5);
+    other.chainCode = m.chainCode;
+    ExtendedKey otherChild = bip32.derive(other, "m/0'/1");
+    BOOST_CHECK_EQUAL(bip32.getCacheHits(), 0);
+    BOOST_CHECK(!(otherChild.publicKey == child.publicKey));
+    BOOST_CHECK(otherChild.publicKey == bip32.derive(bip32.derive(other, Bip32::HARDENED), 1).publicKey);
+}
+
+BOOST_AUTO_TEST_CASE(public_derivation) {
+    Bip32 bip32;
+    ExtendedKey account = bip32.derive(bip32.master(SEED), "m/0'/1");
+    ExtendedKey xpub = bip32.parse(bip32.serialize(bip32.neuter(account)));
+
+    std::vector<Point> children = bip32.derivePublic(xpub, 0, 3);
+    BOOST_REQUIRE_EQUAL(children.size(), 3);
+    for (std::uint32_t i = 0; i < 3; i++) {
+        BOOST_CHECK(children[i] == bip32.derive(account, i).publicKey);
+        BOOST_CHECK(children[i] == bip32.derive(xpub, i).publicKey);
+    }
+
+    BOOST_CHECK_THROW(bip32.derive(xpub, Bip32::HARDENED), std::invalid_argument);
+    BOOST_CHECK_THROW(bip32.derivePublic(xpub, Bip32::HARDENED - 1, 2), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(parse) {
+    Bip32 bip32;
+    std::string xprv = bip32.serialize(bip32.derive(bip32.master(SEED), "m/0'/1/2'"));
+    BOOST_CHECK_EQUAL(bip32.serialize(bip32.parse(xprv)), xprv);
+
+    xprv[20] = xprv[20] == 'a' ? 'b' : 'a';
+    BOOST_CHECK_THROW(bip32.parse(xprv), std::invalid_argument);
+    BOOST_CHECK_THROW(bip32.derive(bip32.master(SEED), "m/0'//1"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,107 @@
+#include <boost/test/unit_test.hpp>
+
+#include <fstream> // std::ofstream
+#include <sstream> // std::istringstream, std::ostringstream
+
+#include "cli.h"
+#include "scoped_file.h"
+
+using namespace Elliptic;
+
+static const std::string PRIVATE_HEX = "0C28FCA386C7A227600B2FE50B7CAE11EC86D3BF1FBE471BE89827E19D72AA1D";
+static const std::string WIF = "5HueCGU8rMjxEXxiPuD5BDku4MkFqeZyd4dZ1jvhTVqvbTLvyTJ";
+
+static int run(const std::vector<std::string>& args, const std::string& input, std::string& output,
+        std::string& errors) {
+    std::istringstream in(input);
+    std::ostringstream out, err;
+    int status = Cli(in, out, err).run(args);
+    output = out.str();
+    errors = err.str();
+    return status;
+}
+
+static std::vector<std::string> lines(const std::string& text) {
+    std::vector<std::string> result;
+    std::istringstream in(text);
+    for (std::string line; std::getline(in, line);) {
+        result.push_back(line);
+    }
+
+    return result;
+}
+
+BOOST_AUTO_TEST_SUITE(cli)
+
+BOOST_AUTO_TEST_CASE(derive_in_order) {
+    Bitcoin bitcoin;
+    std::vector<std::string> keys = bitcoin.generatePrivateHex(3*Cli::BATCH + 5);
+    keys[7] = WIF;
+
+    std::string input, output, errors;
+    for (const std::string& key : keys) {
+        input += key + "\n";
+    }
+
+    BOOST_REQUIRE_EQUAL(run({ "derive", "-a", "-t", "3" }, input, output, errors), 0);
+    BOOST_CHECK(errors.empty());
+
+    std::vector<std::string> addresses = lines(output);
+    BOOST_REQUIRE_EQUAL(addresses.size(), keys.size());
+    BOOST_CHECK_EQUAL(addresses[7], "1LoVGDgRs9hTfTNJNuXKSpywcbdvwRXpmK"); // Compressed
+    for (std::size_t i = 0; i < keys.size(); i += 97) {
+        std::string privateHex = bitcoin.convertToPrivateHex(keys[i]);
+        BOOST_CHECK_EQUAL(addresses[i], bitcoin.publicKeyToAddress(bitcoin.privateHexToPublicKey(privateHex, true)));
+    }
+
+    BOOST_REQUIRE_EQUAL(run({ "derive", "-u" }, PRIVATE_HEX + "\r\n", output, errors), 0);
+    BOOST_CHECK_EQUAL(output, bitcoin.privateHexToPublicKey(PRIVATE_HEX, false) + "\n");
+}
+
+BOOST_AUTO_TEST_CASE(invalid_records) {
+    std::string output, errors;
+    std::string input = WIF + "\n\nnot a key\n" + PRIVATE_HEX + "\n";
+    BOOST_CHECK_EQUAL(run({ "convert" }, input, output, errors), 1);
+    BOOST_CHECK_EQUAL(output, PRIVATE_HEX + "\n\n\n" + PRIVATE_HEX + "\n");
+    BOOST_CHECK(errors.find("line 3:") != std::string::npos);
+    BOOST_CHECK(errors.find("line 2:") == std::string::npos);
+
+    // Blank lines are not errors
+    BOOST_CHECK_EQUAL(run({ "convert" }, WIF + "\n \t\n" + PRIVATE_HEX + "\n", output, errors), 0);
+    BOOST_CHECK_EQUAL(output, PRIVATE_HEX + "\n\n" + PRIVATE_HEX + "\n");
+    BOOST_CHECK(errors.empty());
+
+    BOOST_CHECK_EQUAL(run({ "derive", "--frobnicate" }, "", output, errors), 2);
+    BOOST_CHECK_EQUAL(run({ "generate", "-n" }, "", output, errors), 2);
+    BOOST_CHECK_EQUAL(run({ "derive", "/nonexistent/keys.txt" }, "", output, errors), 1);
+}
+
+BOOST_AUTO_TEST_CASE(compress_file) {
+    Bitcoin bitcoin;
+    std::string uncompressed = bitcoin.privateHexToPublicKey(PRIVATE_HEX, false);
+    std::string compressed = bitcoin.privateHexToPublicKey(PRIVATE_HEX, true);
+
+    // Memory-mapped input without a final newline
+    ScopedFile file = ScopedFile::temporary();
+    std::ofstream(file.path) << uncompressed << "\n" << uncompressed;
+
+    std::string output, errors;
+    BOOST_CHECK_EQUAL(run({ "compress", file.path }, "", output, errors), 0);
+    BOOST_CHECK_EQUAL(output, compressed + "\n" + compressed + "\n");
+
+    BOOST_CHECK_EQUAL(run({ "uncompress" }, compressed + "\n", output, errors), 0);
+    BOOST_CHECK_EQUAL(output, uncompressed + "\n");
+}
+
+BOOST_AUTO_TEST_CASE(generate) {
+    std::string output, errors;
+    BOOST_REQUIRE_EQUAL(run({ "generate", "--count", "2500" }, "", output, errors), 0);
+
+    Bitcoin bitcoin;
+    std::vector<std::string> keys = lines(output);
+    BOOST_REQUIRE_EQUAL(keys.size(), 2500);
+    BOOST_CHECK_EQUAL(bitcoin.convertToPrivateHex(keys.back()), keys.back());
+    BOOST_CHECK(keys[0] != keys[1]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,330 @@
+#include <algorithm>  // std::equal
+#include <functional> // std::function
+
+#include <boost/test/unit_test.hpp>
+
+#include "bitcoin.h"
+#include "field.h"
+#include "secp256k1.h"
+#include "secp256r1.h"
+#include "secp384r1.h"
+#include "simd.h"
+
+using namespace Elliptic;
+
+// RFC 6979, A.2.5 private key
+static const mpz_class K("C9AFA9D845BA75166B5C215767B1D6934E50C3DB36E89B127B8A622B120F6721", 16);
+
+template <std::size_t N>
+static void checkField(const mpz_class& p) {
+    Field<N> field(p);
+    gmp_randclass random(gmp_randinit_default);
+    random.seed(N);
+
+    for (int i = 0; i < 100; i++) {
+        mpz_class a = random.get_z_range(p), b = random.get_z_range(p), r;
+        typename Field<N>::Element x = field.fromMpz(a), y = field.fromMpz(b), z;
+        BOOST_REQUIRE_EQUAL(field.toMpz(x), a);
+
+        field.multiply(z, x, y);
+        BOOST_REQUIRE_EQUAL(field.toMpz(z), a*b % p);
+
+        field.add(z, x, y);
+        BOOST_REQUIRE_EQUAL(field.toMpz(z), (a + b) % p);
+
+        field.subtract(z, x, y);
+        mpz_mod(r.get_mpz_t(), mpz_class(a - b).get_mpz_t(), p.get_mpz_t());
+        BOOST_REQUIRE_EQUAL(field.toMpz(z), r);
+
+        if (sgn(a) != 0) {
+            field.inverse(z, x);
+            mpz_invert(r.get_mpz_t(), a.get_mpz_t(), p.get_mpz_t());
+            BOOST_REQUIRE_EQUAL(field.toMpz(z), r);
+        }
+    }
+}
+
+// Every lane against mpz_class, with a size that leaves padding in the last row
+static void checkVectorField(const mpz_class& p, VectorField::Level level) {
+    const std::size_t n = 37, W = VectorField::WORDS;
+    VectorField field(p, level);
+    gmp_randclass random(gmp_randinit_default);
+    random.seed(level);
+
+    std::vector<mpz_class> a(n), b(n);
+    std::vector<std::uint64_t> words(W*n);
+    for (std::size_t i = 0; i < n; i++) {
+        a[i] = i == 5 ? mpz_class(0) : random.get_z_range(p);
+        b[i] = random.get_z_range(p);
+    }
+
+    VectorField::Vector x = field.vector(n), y = field.vector(n), z;
+    for (std::size_t i = 0; i < n; i++) {
+        mpz_export(&words[W*i], nullptr, -1, sizeof(std::uint64_t), 0, 0, a[i].get_mpz_t());
+    }
+    field.fromWords(x, words.data());
+    std::fill(words.begin(), words.end(), 0);
+    for (std::size_t i = 0; i < n; i++) {
+        mpz_export(&words[W*i], nullptr, -1, sizeof(std::uint64_t), 0, 0, b[i].get_mpz_t());
+    }
+    field.fromWords(y, words.data());
+
+    auto check = [&](const VectorField::Vector& v, std::function<mpz_class(std::size_t)> expected) {
+        field.toWords(words.data(), v);
+        for (std::size_t i = 0; i < n; i++) {
+            mpz_class r;
+            mpz_import(r.get_mpz_t(), W, -1, sizeof(std::uint64_t), 0, 0, &words[W*i]);
+            BOOST_REQUIRE_EQUAL(r, expected(i));
+        }
+    };
+
+    field.multiply(z, x, y);
+    check(z, [&](std::size_t i) { return mpz_class(a[i]*b[i] % p); });
+
+    field.add(z, x, y);
+    check(z, [&](std::size_t i) { return mpz_class((a[i] + b[i]) % p); });
+
+    field.subtract(z, x, y);
+    check(z, [&](std::size_t i) { return mpz_class((a[i] - b[i] + p) % p); });
+
+    field.inverse(z, x);
+    check(z, [&](std::size_t i) {
+        mpz_class r;
+        mpz_invert(r.get_mpz_t(), a[i].get_mpz_t(), p.get_mpz_t());
+        return r;
+    });
+}
+
+BOOST_AUTO_TEST_SUITE(curve)
+
+BOOST_AUTO_TEST_CASE(field_arithmetic) {
+    checkField<1>(mpz_class("FFFFFFFFFFFFFFC5", 16)); // 2^64 - 59
+    checkField<2>(mpz_class("7FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF", 16)); // 2^127 - 1
+    checkField<4>(Secp256k1().getPrime());
+    checkField<6>(Secp384r1().getPrime());
+}
+
+BOOST_AUTO_TEST_CASE(vector_field) {
+    for (int level = VectorField::SCALAR; level <= VectorField::best(); level++) {
+        checkVectorField(Secp256k1().getPrime(), static_cast<VectorField::Level>(level));
+        checkVectorField(Secp256r1().getPrime(), static_cast<VectorField::Level>(level));
+        checkVectorField(mpz_class("FFFFFFFFFFFFFFC5", 16), static_cast<VectorField::Level>(level));
+    }
+
+    BOOST_CHECK_THROW(VectorField(Secp384r1().getPrime()), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(batch_add) {
+    Secp256k1 curve;
+    Point G(mpz_class("79BE667EF9DCBBAC55A06295CE870B07029BFCDB2DCE28D959F2815B16F81798", 16),
+        mpz_class("483ADA7726A3C4655DA4FBFC0E1108A8FD17B448A68554199C47D08FFB10D4B8", 16));
+
+    std::vector<Point> points, q, expected;
+    for (int i = 0; i < 100; i++) {
+        points.push_back(i % 17 == 4 ? Point() : curve.multiply(G, i + 1));
+        q.push_back(i % 23 == 9 ? points.back() : curve.multiply(G, 3*i + 2)); // Doubling
+    }
+    q[50] = curve.negatePoint(points[50]);
+
+    for (int i = 0; i < 100; i++) {
+        expected.push_back(curve.add(points[i], q[i]));
+    }
+
+    std::vector<Point> sums = points;
+    curve.add(sums, q);
+    BOOST_CHECK(sums == expected);
+
+    sums = points;
+    curve.add(sums, G);
+    for (int i = 0; i < 100; i++) {
+        BOOST_CHECK(sums[i] == curve.add(points[i], G));
+    }
+
+    // The mpz_class fallback, over a batch beyond what its scratch keeps and then a small one
+    Curve wide(0, 7, (mpz_class(1) << 607) - 1);
+    mpz_class x = 1, y;
+    for (;; x++) {
+        y = wide.squareRoot(x*x*x + 7);
+        if (wide.hasPoint(Point(x, y))) {
+            break;
+        }
+    }
+
+    std::vector<Point> multiples = { Point(x, y) };
+    for (int i = 1; i < 5000; i++) {
+        multiples.push_back(wide.add(multiples.back(), multiples.front()));
+    }
+
+    for (std::size_t n : { 4999, 10 }) {
+        sums.assign(multiples.begin(), multiples.begin() + n);
+        wide.add(sums, multiples.front());
+        BOOST_CHECK(std::equal(sums.begin(), sums.end(), multiples.begin() + 1));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(secp256r1) {
+    Secp256r1 curve;
+    Point G = curve.getBasePoint();
+    BOOST_CHECK(curve.hasPoint(G));
+    BOOST_CHECK(curve.multiply(G, curve.getOrder()).isZero());
+
+    Point Q = curve.multiply(G, K);
+    BOOST_CHECK_EQUAL(Q.getX().get_str(16), "60fed4ba255a9d31c961eb74c6356d68c049b8923b61fa6ce669622e60f29fb6");
+    BOOST_CHECK_EQUAL(Q.getY().get_str(16), "7903fe1008b8bc99a41ae9e95628bc64f2f1b20c2d7e9f5177a3c294d4462299");
+    BOOST_CHECK(curve.add(Q, curve.negatePoint(Q)).isZero());
+    BOOST_CHECK(curve.add(Q, Q) == curve.multiply(Q));
+}
+
+BOOST_AUTO_TEST_CASE(secp384r1) {
+    Secp384r1 curve;
+    Point G = curve.getBasePoint();
+    BOOST_CHECK(curve.hasPoint(G));
+    BOOST_CHECK(curve.multiply(G, curve.getOrder()).isZero());
+
+    Point Q = curve.multiply(G, K);
+    BOOST_CHECK_EQUAL(Q.getX().get_str(16),
+        "7c230d20b5acb84e2751245cfea6c662892bcf8486a018127aa5e16049a6fdd8ab5326d0f69b5b708eb595ab4ed6ef6");
+    BOOST_CHECK(curve.hasPoint(Q));
+}
+
+BOOST_AUTO_TEST_CASE(p521) {
+    mpz_class p = 1;
+    p = (p << 521) - 1;
+    Curve curve(p - 3, mpz_class("0051953EB9618E1C9A1F929A21A0B68540EEA2DA725B99B315F3B8B489918EF109E1"
+        "56193951EC7E937B1652C0BD3BB1BF073573DF883D2C34F1EF451FD46B503F00", 16), p);
+    Point G(mpz_class("00C6858E06B70404E9CD9E3ECB662395B4429C648139053FB521F828AF606B4D3DBAA14B5E77EF"
+        "E75928FE1DC127A2FFA8DE3348B3C1856A429BF97E7E31C2E5BD66", 16),
+        mpz_class("011839296A789A3BC0045C8A5FB42C7D1BD998F54449579B446817AFBD17273E662C97EE72995E"
+        "F42640C550B9013FAD0761353C7086A272C24088BE94769FD16650", 16));
+    mpz_class n("01FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFA51868783BF2F966B7FC"
+        "C0148F709A5D03BB5C9B8899C47AEBB6FB71E91386409", 16);
+
+    BOOST_CHECK(curve.hasPoint(G));
+    BOOST_CHECK(curve.multiply(G, n).isZero());
+    BOOST_CHECK_EQUAL(curve.multiply(G, K).getX().get_str(16),
+        "8d350b66b953da1a1d2d3eaac4bdf57f01504a72fd8f9cb9ec042851e155a343abcba5f738758d0c1564eae62b18becfd0d79f6a22e9e63f54d95abb4ae01a27c4");
+}
+
+static void checkMsm(const Curve& curve, const Point& G, std::size_t n, std::size_t bits) {
+    gmp_randclass random(gmp_randinit_default);
+    random.seed(n);
+
+    std::vector<Point> points;
+    std::vector<mpz_class> scalars;
+    Point expected;
+    for (std::size_t i = 0; i < n; i++) {
+        points.push_back(curve.multiply(G, random.get_z_bits(64) + 1));
+        scalars.push_back(i % 7 == 3 ? mpz_class(0) : random.get_z_bits(bits));
+        if (sgn(scalars.back()) != 0) {
+            expected = curve.add(expected, curve.multiply(points.back(), scalars.back()));
+        }
+    }
+
+    BOOST_CHECK(curve.multiply(points, scalars) == expected);
+    BOOST_CHECK(curve.multiply(points, scalars, 4) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(multi_scalar) {
+    Secp256k1 secp256k1;
+    Point G(mpz_class("79BE667EF9DCBBAC55A06295CE870B07029BFCDB2DCE28D959F2815B16F81798", 16),
+        mpz_class("483ADA7726A3C4655DA4FBFC0E1108A8FD17B448A68554199C47D08FFB10D4B8", 16));
+    checkMsm(secp256k1, G, 1, 256);
+    checkMsm(secp256k1, G, 5, 256);   // Straus
+    checkMsm(secp256k1, G, 300, 256); // Pippenger
+
+    // P = -P sums to the identity
+    BOOST_CHECK(secp256k1.multiply({ G, secp256k1.negatePoint(G) }, { 5, 5 }).isZero());
+    BOOST_CHECK_THROW(secp256k1.multiply({ G }, { -1 }), std::invalid_argument);
+
+    // 2^607 - 1 is wider than the field backends
+    mpz_class p = 1;
+    p = (p << 607) - 1;
+    Curve curve(0, 7, p);
+    mpz_class x = 1, y;
+    for (;; x++) {
+        y = curve.squareRoot(x*x*x + 7);
+        if (curve.hasPoint(Point(x, y))) {
+            break;
+        }
+    }
+
+    checkMsm(curve, Point(x, y), 3, 64);
+    checkMsm(curve, Point(x, y), 40, 16);
+}
+
+// Every point of the range, walked whole and split, against scalar multiplication
+static void checkKeyRange(const Curve& curve, const Point& G, const mpz_class& first, std::uint64_t count,
+        const mpz_class& stride) {
+    KeyRange range(curve, G, first, count, stride);
+    std::vector<Point> expected, points, walked;
+    for (std::uint64_t i = 0; i < count; i++) {
+        mpz_class k = first + stride*i;
+        expected.push_back(sgn(k) == 0 ? Point() : curve.multiply(G, k));
+    }
+
+    while (range.next(points)) {
+        BOOST_REQUIRE(points.size() <= KeyRange::BATCH);
+        walked.insert(walked.end(), points.begin(), points.end());
+    }
+    BOOST_CHECK(walked == expected);
+    BOOST_CHECK_EQUAL(range.position(), count);
+
+    walked.clear();
+    std::vector<KeyRange> parts = range.split(3);
+    BOOST_REQUIRE_EQUAL(parts.size(), std::min<std::uint64_t>(3, std::max<std::uint64_t>(count, 1)));
+    for (KeyRange& part : parts) {
+        BOOST_CHECK(part.getFirst() == range.key(walked.size()));
+        while (part.next(points)) {
+            walked.insert(walked.end(), points.begin(), points.end());
+        }
+    }
+    BOOST_CHECK(walked == expected);
+}
+
+BOOST_AUTO_TEST_CASE(key_range) {
+    Secp256k1 secp256k1;
+    Bitcoin bitcoin;
+    Point G = bitcoin.getBasePoint();
+    checkKeyRange(secp256k1, G, K, 2*KeyRange::BATCH + 37, 1);
+    checkKeyRange(secp256k1, G, 1, 100, 7);
+    checkKeyRange(secp256k1, G, 5, 1, 1);
+    checkKeyRange(secp256k1, G, 5, 0, 1);
+
+    // Crosses the identity, (n - 2)G + 2G, and doubles, 3G + 3G with stride 3
+    mpz_class n = secp256k1.getOrder();
+    checkKeyRange(secp256k1, G, n - 2, 5, 1);
+    checkKeyRange(secp256k1, G, 3, 4, 3);
+
+    // Starts at the identity, 0G
+    checkKeyRange(secp256k1, G, 0, KeyRange::BATCH + 3, 1);
+    checkKeyRange(secp256k1, G, 0, 4, 5);
+
+    // 2^607 - 1 is wider than the field backends
+    Curve curve(0, 7, (mpz_class(1) << 607) - 1);
+    mpz_class x = 1, y;
+    for (;; x++) {
+        y = curve.squareRoot(x*x*x + 7);
+        if (curve.hasPoint(Point(x, y))) {
+            break;
+        }
+    }
+    checkKeyRange(curve, Point(x, y), 12345, 300, 2);
+
+    KeyRange range = bitcoin.keyRange("5HueCGU8rMjxEXxiPuD5BDku4MkFqeZyd4dZ1jvhTVqvbTLvyTJ", 3);
+    std::vector<Point> points;
+    BOOST_REQUIRE(range.next(points));
+    BOOST_CHECK_EQUAL(bitcoin.pointToAddress(points[0], false), "1GAehh7TsJAHuUAeKZcXf5CnwuGuGgyX2S");
+
+    std::string last = mpz_class(n - 3).get_str(16);
+    BOOST_CHECK_NO_THROW(bitcoin.keyRange(last, 3));
+    BOOST_CHECK_THROW(bitcoin.keyRange(last, 4), std::invalid_argument);
+    BOOST_CHECK_THROW(bitcoin.keyRange(last, 1, 0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(discriminant) {
+    BOOST_CHECK_THROW(Curve(0, 0, 37), std::invalid_argument);
+    BOOST_CHECK_THROW(Curve(-3, 2, 37), std::invalid_argument);
+    BOOST_CHECK_THROW(Curve(7, 2, 37), std::invalid_argument); // 4 7^3 + 27 2^2 = 40 37
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,111 @@
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>  // std::stoul
+#include <fstream>  // std::ifstream
+#include <iterator> // std::istreambuf_iterator
+
+#include "bitcoin.h"
+#include "pdf.h"
+#include "scoped_file.h"
+
+using namespace Elliptic;
+
+static std::string read(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    BOOST_REQUIRE(file);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+/**
+ * Checks the cross-reference table of the document against its objects and
+ * returns the page count of the page tree.
+ */
+static std::size_t checkStructure(const std::string& pdf) {
+    BOOST_REQUIRE_EQUAL(pdf.compare(0, 9, "%PDF-1.4\n"), 0);
+
+    const std::string end = "\n%%EOF\n";
+    BOOST_REQUIRE(pdf.size() > end.size());
+    BOOST_REQUIRE_EQUAL(pdf.compare(pdf.size() - end.size(), end.size(), end), 0);
+
+    std::size_t startxref = pdf.rfind("startxref\n");
+    BOOST_REQUIRE(startxref != std::string::npos);
+    std::size_t xref = std::stoul(pdf.substr(startxref + 10));
+    BOOST_REQUIRE_EQUAL(pdf.compare(xref, 7, "xref\n0 "), 0);
+
+    std::size_t line = pdf.find('\n', xref + 5);
+    std::size_t size = std::stoul(pdf.substr(xref + 7, line - xref - 7));
+    BOOST_REQUIRE_EQUAL(pdf.compare(line + 1, 20, "0000000000 65535 f \n"), 0);
+
+    // Fixed 20-byte entries, each pointing at the header of its object
+    std::size_t entries = line + 21;
+    for (std::size_t i = 1; i < size; i++) {
+        std::string entry = pdf.substr(entries + 20*(i - 1), 20);
+        BOOST_REQUIRE_EQUAL(entry.substr(10), " 00000 n \n");
+
+        std::string header = std::to_string(i) + " 0 obj\n";
+        BOOST_CHECK_EQUAL(pdf.compare(std::stoul(entry.substr(0, 10)), header.size(), header), 0);
+    }
+
+    // Every object is listed, and nothing else precedes the trailer
+    BOOST_CHECK_EQUAL(pdf.find(std::to_string(size) + " 0 obj\n"), std::string::npos);
+    BOOST_CHECK_EQUAL(pdf.compare(entries + 20*(size - 1), 17, "trailer\n<< /Size "), 0);
+    BOOST_CHECK_EQUAL(std::stoul(pdf.substr(entries + 20*(size - 1) + 17)), size);
+
+    std::size_t count = pdf.find("/Count ");
+    BOOST_REQUIRE(count != std::string::npos);
+    std::size_t pages = std::stoul(pdf.substr(count + 7));
+
+    // Catalog, page tree and two fonts, then a page and its content per page
+    BOOST_CHECK_EQUAL(size, 1 + 4 + 2*pages);
+    return pages;
+}
+
+static std::size_t occurrences(const std::string& text, const std::string& pattern) {
+    std::size_t result = 0;
+    for (std::size_t i = text.find(pattern); i != std::string::npos; i = text.find(pattern, i + 1)) {
+        result++;
+    }
+
+    return result;
+}
+
+BOOST_AUTO_TEST_SUITE(pdf)
+
+BOOST_AUTO_TEST_CASE(structure) {
+    ScopedFile file = ScopedFile::temporary();
+
+    Pdf pdf;
+    pdf.addPage(Pdf::text(72, 720, 12, "First (page) \\ escaped"));
+    pdf.addPage(Pdf::rectangle(36, 36, 540, 144));
+    pdf.addPage(Pdf::qrCode(QRCode("1LoVGDgRs9hTfTNJNuXKSpywcbdvwRXpmK"), 36, 36, 96));
+    pdf.save(file.path);
+
+    std::string content = read(file.path);
+    BOOST_CHECK_EQUAL(checkStructure(content), 3);
+    BOOST_CHECK_EQUAL(occurrences(content, "/Type /Page "), 3);
+    BOOST_CHECK(content.find("(First \\(page\\) \\\\ escaped) Tj") != std::string::npos);
+
+    Pdf empty;
+    empty.save(file.path);
+    BOOST_CHECK_EQUAL(checkStructure(read(file.path)), 0);
+}
+
+BOOST_AUTO_TEST_CASE(paper_wallets) {
+    Bitcoin bitcoin;
+    std::vector<std::string> keys = bitcoin.generatePrivateHex(9);
+
+    ScopedFile file = ScopedFile::temporary();
+    bitcoin.paperWallets(keys, true, Bitcoin::NATIVE, file.path);
+
+    // Four wallets per page, each key rendered exactly once
+    std::string content = read(file.path);
+    BOOST_CHECK_EQUAL(checkStructure(content), 3);
+    BOOST_CHECK_EQUAL(occurrences(content, "/Type /Page "), 3);
+    for (const std::string& key : keys) {
+        std::string address = bitcoin.publicKeyToAddress(bitcoin.privateHexToPublicKey(key, true));
+        BOOST_CHECK_EQUAL(occurrences(content, "(" + address + ") Tj"), 1);
+        BOOST_CHECK_EQUAL(occurrences(content, "(" + bitcoin.privateHexToWIF(key, true) + ") Tj"), 1);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
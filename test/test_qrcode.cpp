@@ -0,0 +1,134 @@
+#include <boost/test/unit_test.hpp>
+
+#include <string> // std::string
+#include <vector> // std::vector
+
+#include "qrcode.h"
+
+using namespace Elliptic;
+
+static const std::string ADDRESS = "1LoVGDgRs9hTfTNJNuXKSpywcbdvwRXpmK";
+static const std::string WIF = "5HueCGU8rMjxEXxiPuD5BDku4MkFqeZyd4dZ1jvhTVqvbTLvyTJ";
+
+// Reference symbols from an independent encoder written from ISO/IEC 18004,
+// one string per row, '#' for a dark module
+static const std::vector<std::string> ADDRESS_MODULES = {
+    "#######...##.###.#.##.#######",
+    "#.....#..#..#####.#...#.....#",
+    "#.###.#.##..##.#......#.###.#",
+    "#.###.#.#...#.##.#..#.#.###.#",
+    "#.###.#.##.#...##..##.#.###.#",
+    "#.....#.#.#.#....#..#.#.....#",
+    "#######.#.#.#.#.#.#.#.#######",
+    "........##.#..#.#..#.........",
+    "#.#####..##.#....#..#.#####..",
+    "####.#..##...###..#.######...",
+    "##..###..##..######.#...#.#..",
+    "##.#.#..#.####.....#.#####..#",
+    "....###.#.#.#.#..#.#...##...#",
+    ".....#..#.###..##.#.#..###.##",
+    "#..####.##.....####.....###..",
+    "...###.#..#.#.###.#..#...#.#.",
+    "...#..####..#....#.##.......#",
+    "#..#...####..##.#.#.##.###.#.",
+    "#.#...####..####....#.###....",
+    "#.#..#..#.##.#.#..#.###..#...",
+    "#...####..#...####..#####.##.",
+    "........#.#.#...#..##...##..#",
+    "#######..##.#..#.#.##.#.####.",
+    "#.....#.#####.##..###...##.##",
+    "#.###.#.##......##..######.#.",
+    "#.###.#.###.#.###...#..#...##",
+    "#.###.#.#...#.##.#.###..#.##.",
+    "#.....#..#..###......###.#.#.",
+    "#######.#..##.###..#.##.###.."
+};
+
+static const std::vector<std::string> WIF_MODULES = {
+    "#######...#.#...#.#.###...#######",
+    "#.....#..#.##..##.#.......#.....#",
+    "#.###.#.#.#.#.##...#.#....#.###.#",
+    "#.###.#.#####..#..#..##.#.#.###.#",
+    "#.###.#.##..#.###...#.##..#.###.#",
+    "#.....#.##..#.#....#.#..#.#.....#",
+    "#######.#.#.#.#.#.#.#.#.#.#######",
+    "........###.#.#.#.####.#.........",
+    "#.#####..#....#.##.#..#.#.#####..",
+    "#.......#.#####.###.###..###...##",
+    "....###.####.###.#..###.##....#..",
+    "#...#.....##.#..###.##..#.#..##..",
+    "##..####.#.##.###....###.#..##.#.",
+    ".####..#...#.#.#.##....#..#..##..",
+    ".#.#.##.###.#..####..#....###.##.",
+    "######.#.#..#..#...#.#..#..#####.",
+    "#..####.......##.#.##.#..#.....#.",
+    "######.###..#..##..#...#.##..##.#",
+    "#.#.#.###.###.###.#..##.#.#.####.",
+    "##.#.#.#.#.#..#.....##.##....###.",
+    "##..####...###....#...##.#.##...#",
+    "###..#..##..##.##...#.##.#...####",
+    "#..#####..###.#......#..#.....#..",
+    "#.#.#..#..#.###.#...####..##.####",
+    "#..##.###..#..#..##..##.#######..",
+    "........###.#.#.##..###.#...#####",
+    "#######...#.##.###..#.###.#.####.",
+    "#.....#.#.####.####.##.##...###.#",
+    "#.###.#.#.#.#...#...#.#.#####.#.#",
+    "#.###.#.#.#....#..#.######.#...##",
+    "#.###.#.#.#######...##.#.........",
+    "#.....#...##..##..#..#.###..#.#..",
+    "#######.######.#...##.###..#.#.#."
+};
+
+static std::vector<std::string> modules(const QRCode& code) {
+    std::vector<std::string> rows(code.getSize(), std::string(code.getSize(), '.'));
+    for (int y = 0; y < code.getSize(); y++) {
+        for (int x = 0; x < code.getSize(); x++) {
+            if (code.getModule(x, y)) {
+                rows[y][x] = '#';
+            }
+        }
+    }
+
+    return rows;
+}
+
+/**
+ * The 15 format bits read from the copy around the top left finder pattern,
+ * most significant first, with the 0x5412 mask removed.
+ */
+static int formatBits(const QRCode& code) {
+    const int positions[15][2] = { { 0, 8 }, { 1, 8 }, { 2, 8 }, { 3, 8 }, { 4, 8 }, { 5, 8 },
+        { 7, 8 }, { 8, 8 }, { 8, 7 }, { 8, 5 }, { 8, 4 }, { 8, 3 }, { 8, 2 }, { 8, 1 }, { 8, 0 } };
+
+    int bits = 0;
+    for (const auto& position : positions) {
+        bits = bits << 1 | code.getModule(position[0], position[1]);
+    }
+
+    return bits ^ 0x5412;
+}
+
+BOOST_AUTO_TEST_SUITE(qrcode)
+
+BOOST_AUTO_TEST_CASE(known_answer) {
+    QRCode address(ADDRESS);
+    BOOST_CHECK_EQUAL(address.getSize(), 4*3 + 17); // Version 3
+    BOOST_CHECK_EQUAL(formatBits(address) >> 13, 0); // Level M
+    BOOST_CHECK_EQUAL(formatBits(address) >> 10 & 7, 2); // Mask 2
+    BOOST_CHECK(modules(address) == ADDRESS_MODULES);
+
+    // Two interleaved Reed-Solomon blocks
+    QRCode WIFCode(WIF);
+    BOOST_CHECK_EQUAL(WIFCode.getSize(), 4*4 + 17); // Version 4
+    BOOST_CHECK_EQUAL(formatBits(WIFCode) >> 13, 0);
+    BOOST_CHECK_EQUAL(formatBits(WIFCode) >> 10 & 7, 2);
+    BOOST_CHECK(modules(WIFCode) == WIF_MODULES);
+}
+
+BOOST_AUTO_TEST_CASE(capacity) {
+    BOOST_CHECK_EQUAL(QRCode(std::string(213, 'Z')).getSize(), 4*10 + 17);
+    BOOST_CHECK_THROW(QRCode(std::string(214, 'Z')), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,76 @@
+#include <boost/test/unit_test.hpp>
+
+#include <cstring> // std::memcmp
+#include <set>     // std::set
+
+#include <sys/wait.h> // waitpid
+#include <unistd.h>   // fork, pipe, read, write, _exit
+
+#include "hash.h"
+#include "random.h"
+
+using namespace Elliptic;
+
+BOOST_AUTO_TEST_SUITE(csprng)
+
+BOOST_AUTO_TEST_CASE(chacha20_block) {
+    // RFC 7539, section 2.3.2
+    const std::uint32_t key[8] = {
+        0x03020100, 0x07060504, 0x0B0A0908, 0x0F0E0D0C,
+        0x13121110, 0x17161514, 0x1B1A1918, 0x1F1E1D1C
+    };
+    const std::uint32_t nonce[3] = { 0x09000000, 0x4A000000, 0x00000000 };
+
+    std::uint8_t block[64];
+    Random::chacha20(key, 1, nonce, block);
+    BOOST_CHECK_EQUAL(Hash::byteToHex(block, 64),
+        "10f1e7e4d13b5915500fdd1fa32071c4c7d1f4c733c068030422aa9ac3d46c4e"
+        "d2826446079faa0914c2d705d98b02a2b5129cd1de164eb9cbd083e8a2503c4e");
+}
+
+BOOST_AUTO_TEST_CASE(scalars_in_range) {
+    std::set<int> seen;
+    for (const Random::Scalar& s : Random::scalars(37, 2000)) {
+        for (std::size_t i = 0; i < s.size() - 1; i++) {
+            BOOST_REQUIRE_EQUAL(s[i], 0);
+        }
+
+        BOOST_REQUIRE(s.back() >= 1 && s.back() < 37);
+        seen.insert(s.back());
+    }
+
+    BOOST_CHECK_EQUAL(seen.size(), 36);
+}
+
+BOOST_AUTO_TEST_CASE(fork_reseeds) {
+    // Leaves most of the keystream buffer unread before forking
+    std::uint8_t before[32], parent[32], child[32] = {};
+    Random::bytes(before, sizeof(before));
+
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(pipe(fds), 0);
+    pid_t pid = fork();
+    BOOST_REQUIRE(pid >= 0);
+    if (pid == 0) {
+        Random::bytes(child, sizeof(child));
+        _exit(write(fds[1], child, sizeof(child)) == sizeof(child) ? 0 : 1);
+    }
+
+    Random::bytes(parent, sizeof(parent));
+    close(fds[1]);
+    BOOST_REQUIRE_EQUAL(read(fds[0], child, sizeof(child)), sizeof(child));
+    close(fds[0]);
+
+    int status;
+    waitpid(pid, &status, 0);
+    BOOST_CHECK(std::memcmp(parent, child, sizeof(parent)) != 0);
+}
+
+BOOST_AUTO_TEST_CASE(fast_uniform) {
+    for (int i = 0; i < 1000; i++) {
+        mpz_class r = FastRandom::local().uniform(1000);
+        BOOST_REQUIRE(sgn(r) >= 0 && r < 1000);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
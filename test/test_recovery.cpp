@@ -0,0 +1,71 @@
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio> // std::remove
+
+#include "recovery.h"
+
+using namespace Elliptic;
+
+static const std::string PRIVATE_HEX = "0C28FCA386C7A227600B2FE50B7CAE11EC86D3BF1FBE471BE89827E19D72AA1D";
+
+BOOST_AUTO_TEST_SUITE(recovery)
+
+BOOST_AUTO_TEST_CASE(wif_checksum) {
+    // 5HueCGU8rMjxEXxiPuD5BDku4MkFqeZyd4dZ1jvhTVqvbTLvyTJ
+    Recovery recovery("5HueCGU8rMjxEXxiPuD5BDku4Mk?qeZyd4dZ1jvhTVqvb?LvyT?");
+    BOOST_CHECK_EQUAL(recovery.getCandidates(), 58*58*58);
+
+    std::uint64_t reported = 0;
+    std::vector<Recovery::Match> matches = recovery.search("", [&](std::uint64_t done, std::uint64_t total) {
+        BOOST_CHECK(done <= total);
+        reported = done;
+    });
+
+    BOOST_CHECK_EQUAL(reported, recovery.getCandidates());
+    BOOST_REQUIRE_EQUAL(matches.size(), 1);
+    BOOST_CHECK_EQUAL(matches[0].privateHex, PRIVATE_HEX);
+    BOOST_CHECK(!matches[0].compressed);
+}
+
+BOOST_AUTO_TEST_CASE(wif_checkpoint) {
+    const std::string checkpoint = "recovery_test.checkpoint";
+    std::remove(checkpoint.c_str());
+
+    Bitcoin bitcoin;
+    Recovery recovery("KwdMAjGmerYanjeui5SHS7JkmpZvVipYvB2LJGU1ZxJw?vP9861?");
+    recovery.addTarget(bitcoin.publicKeyToAddress(bitcoin.privateHexToPublicKey(PRIVATE_HEX, true)));
+    std::vector<Recovery::Match> matches = recovery.search(checkpoint);
+    BOOST_REQUIRE_EQUAL(matches.size(), 1);
+    BOOST_CHECK(matches[0].compressed);
+
+    // Resuming a finished search only returns the saved matches
+    std::vector<Recovery::Match> resumed = recovery.search(checkpoint, [](std::uint64_t, std::uint64_t) {
+        BOOST_FAIL("No blocks should be searched again");
+    });
+    BOOST_REQUIRE_EQUAL(resumed.size(), 1);
+    BOOST_CHECK_EQUAL(resumed[0].privateHex, PRIVATE_HEX);
+
+    BOOST_CHECK_THROW(Recovery("KwdMAjGmerYanjeui5SHS7JkmpZvVipYvB2LJGU1ZxJwYvP986??").search(checkpoint),
+        std::invalid_argument);
+    std::remove(checkpoint.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(dice_target) {
+    Bitcoin bitcoin;
+    std::string dice = "014524421500223421024422053020251555234143220245121523053344504534305350253544403052452450205213341";
+    for (std::size_t i : { 3, 40, 41, 77, 98 }) {
+        dice[i] = Recovery::WILDCARD;
+    }
+
+    Recovery recovery(dice);
+    BOOST_CHECK_THROW(recovery.search(), std::invalid_argument);
+
+    std::string publicKey = bitcoin.privateHexToPublicKey(PRIVATE_HEX, false);
+    recovery.addTarget(Hash::ripemd160(Hash::sha256(publicKey)));
+    std::vector<Recovery::Match> matches = recovery.search();
+    BOOST_REQUIRE_EQUAL(matches.size(), 1);
+    BOOST_CHECK_EQUAL(matches[0].privateHex, PRIVATE_HEX);
+    BOOST_CHECK(!matches[0].compressed);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,227 @@
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>  // std::remove
+#include <fstream> // std::ifstream, std::ofstream
+#include <map>     // std::map
+#include <thread>  // std::thread
+
+#include "scoped_file.h"
+#include "server.h"
+
+using namespace Elliptic;
+
+static const std::string PRIVATE_HEX = "0C28FCA386C7A227600B2FE50B7CAE11EC86D3BF1FBE471BE89827E19D72AA1D";
+static const std::string ORDER = "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141";
+
+/**
+ * Server running on its own thread for the lifetime of the fixture.
+ */
+struct ServerFixture {
+    Server server;
+    std::thread thread;
+
+    explicit ServerFixture(const Server::Options& options) : server(options), thread([this]() { server.run(); }) {}
+
+    ~ServerFixture() {
+        server.stop();
+        thread.join();
+    }
+};
+
+/**
+ * A path under /tmp that no other test uses, left free for the server to bind.
+ */
+static std::string socketPath() {
+    ScopedFile file = ScopedFile::temporary();
+    return file.path;
+}
+
+static Server::Options options(const std::string& path, std::size_t maxBatch, unsigned deadline) {
+    Server::Options options;
+    options.path = path;
+    options.maxBatch = maxBatch;
+    options.deadline = std::chrono::microseconds(deadline);
+    options.workers = 2;
+    return options;
+}
+
+static std::string toHex(const std::string& bytes) {
+    static const char* DIGITS = "0123456789ABCDEF";
+    std::string hex;
+    for (unsigned char c : bytes) {
+        hex += DIGITS[c >> 4];
+        hex += DIGITS[c & 0xF];
+    }
+
+    return hex;
+}
+
+BOOST_AUTO_TEST_SUITE(server)
+
+BOOST_AUTO_TEST_CASE(derive) {
+    std::string path = socketPath();
+    ServerFixture fixture(options(path, 256, 200));
+    ServerClient client(path);
+    Bitcoin bitcoin;
+
+    client.send(1, Server::PUBLIC_KEY, PRIVATE_HEX, false);
+    client.send(2, Server::PUBLIC_KEY, PRIVATE_HEX);
+    client.send(3, Server::ADDRESS, PRIVATE_HEX);
+    client.send(4, Server::ADDRESS, PRIVATE_HEX, false);
+
+    std::map<std::uint32_t, ServerClient::Response> responses;
+    for (int i = 0; i < 4; i++) {
+        ServerClient::Response response = client.receive();
+        responses[response.id] = response;
+    }
+
+    for (std::uint32_t id = 1; id <= 4; id++) {
+        BOOST_CHECK_EQUAL(responses[id].status, Server::OK);
+    }
+
+    BOOST_CHECK_EQUAL(toHex(responses[1].payload), bitcoin.privateHexToPublicKey(PRIVATE_HEX, false));
+    BOOST_CHECK_EQUAL(toHex(responses[2].payload), bitcoin.privateHexToPublicKey(PRIVATE_HEX, true));
+    BOOST_CHECK_EQUAL(responses[3].payload, "1LoVGDgRs9hTfTNJNuXKSpywcbdvwRXpmK");
+    BOOST_CHECK_EQUAL(responses[4].payload, "1GAehh7TsJAHuUAeKZcXf5CnwuGuGgyX2S");
+}
+
+BOOST_AUTO_TEST_CASE(invalid_requests) {
+    std::string path = socketPath();
+    ServerFixture fixture(options(path, 256, 100));
+    ServerClient client(path);
+
+    client.send(1, Server::ADDRESS, "0");
+    client.send(2, Server::ADDRESS, ORDER);
+    client.send(3, static_cast<Server::Op>(7), PRIVATE_HEX);
+    client.send(4, Server::ADDRESS, PRIVATE_HEX);
+
+    std::map<std::uint32_t, Server::Status> statuses;
+    for (int i = 0; i < 4; i++) {
+        ServerClient::Response response = client.receive();
+        statuses[response.id] = response.status;
+    }
+
+    BOOST_CHECK_EQUAL(statuses[1], Server::INVALID_KEY);
+    BOOST_CHECK_EQUAL(statuses[2], Server::INVALID_KEY);
+    BOOST_CHECK_EQUAL(statuses[3], Server::BAD_REQUEST);
+    BOOST_CHECK_EQUAL(statuses[4], Server::OK);
+
+    // Only key derivations are counted, not the bad request or STATS itself
+    Server::Stats stats = client.stats();
+    BOOST_CHECK_EQUAL(stats.requests, 3);
+    BOOST_CHECK_EQUAL(stats.errors, 2);
+    BOOST_CHECK_EQUAL(client.stats().requests, 3);
+
+    BOOST_CHECK_THROW(client.send(5, Server::ADDRESS, "not hex"), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(coalescing) {
+    // A long deadline makes every pipelined burst wait for a full batch
+    std::string path = socketPath();
+    ServerFixture fixture(options(path, 64, 50000));
+    ServerClient::Report report = ServerClient::load(path, 4, 2048, 128, Server::PUBLIC_KEY);
+    BOOST_CHECK_EQUAL(report.requests, 2048);
+    BOOST_CHECK_EQUAL(report.errors, 0);
+    BOOST_CHECK(report.p50 <= report.p99);
+
+    Server::Stats stats = ServerClient(path).stats();
+    BOOST_CHECK_EQUAL(stats.requests, 2048);
+    BOOST_CHECK_EQUAL(stats.errors, 0);
+    BOOST_CHECK(stats.batches >= 2048 / 64);
+    BOOST_CHECK(stats.batches < 2048 / 8);
+    BOOST_CHECK(stats.p99 > 0);
+}
+
+BOOST_AUTO_TEST_CASE(deadline) {
+    // A lone request is answered once its deadline passes, without a full batch
+    std::string path = socketPath();
+    ServerFixture fixture(options(path, 256, 1000));
+    ServerClient client(path);
+    client.send(9, Server::ADDRESS, PRIVATE_HEX);
+    ServerClient::Response response = client.receive();
+    BOOST_CHECK_EQUAL(response.id, 9);
+    BOOST_CHECK_EQUAL(response.payload, "1LoVGDgRs9hTfTNJNuXKSpywcbdvwRXpmK");
+
+    Server::Stats stats = client.stats();
+    BOOST_CHECK_EQUAL(stats.batches, 1);
+    BOOST_CHECK(stats.p50 >= 1000000);
+}
+
+BOOST_AUTO_TEST_CASE(socket_path) {
+    // A regular file at the path is left alone
+    ScopedFile file = ScopedFile::temporary();
+    const std::string& path = file.path;
+    std::ofstream(path) << "not a socket";
+    BOOST_CHECK_THROW(Server server(options(path, 256, 200)), std::runtime_error);
+
+    std::string content;
+    std::getline(std::ifstream(path), content);
+    BOOST_CHECK_EQUAL(content, "not a socket");
+    std::remove(path.c_str());
+
+    // A socket left behind by an earlier server is replaced
+    {
+        Server first(options(path, 256, 200));
+        Server second(options(path, 256, 200));
+    }
+
+    ServerFixture fixture(options(path, 256, 200));
+    ServerClient client(path);
+    client.send(1, Server::ADDRESS, PRIVATE_HEX);
+    BOOST_CHECK_EQUAL(client.receive().payload, "1LoVGDgRs9hTfTNJNuXKSpywcbdvwRXpmK");
+}
+
+BOOST_AUTO_TEST_CASE(half_close) {
+    // Requests sent before the client shuts down its sending side are answered
+    std::string path = socketPath();
+    ServerFixture fixture(options(path, 256, 1000));
+    ServerClient client(path);
+    for (std::uint32_t id = 1; id <= 3; id++) {
+        client.send(id, Server::ADDRESS, PRIVATE_HEX);
+    }
+
+    client.send(4, static_cast<Server::Op>(7), PRIVATE_HEX);
+    client.finish();
+
+    std::map<std::uint32_t, Server::Status> statuses;
+    for (int i = 0; i < 4; i++) {
+        ServerClient::Response response = client.receive();
+        statuses[response.id] = response.status;
+    }
+
+    BOOST_CHECK_EQUAL(statuses.size(), 4);
+    BOOST_CHECK_EQUAL(statuses[3], Server::OK);
+    BOOST_CHECK_EQUAL(statuses[4], Server::BAD_REQUEST);
+
+    // Then the server closes the connection
+    BOOST_CHECK_THROW(client.receive(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(outstanding_limit) {
+    // Reading pauses at 8 unanswered requests and resumes as they complete
+    std::string path = socketPath();
+    Server::Options limited = options(path, 4, 200);
+    limited.maxOutstanding = 8;
+    ServerFixture fixture(limited);
+    ServerClient client(path);
+
+    const std::uint32_t count = 100;
+    for (std::uint32_t id = 0; id < count; id++) {
+        client.send(id, Server::ADDRESS, PRIVATE_HEX);
+    }
+
+    std::map<std::uint32_t, std::string> payloads;
+    for (std::uint32_t i = 0; i < count; i++) {
+        ServerClient::Response response = client.receive();
+        BOOST_CHECK_EQUAL(response.status, Server::OK);
+        payloads[response.id] = response.payload;
+    }
+
+    BOOST_CHECK_EQUAL(payloads.size(), count);
+    BOOST_CHECK_EQUAL(payloads[count - 1], "1LoVGDgRs9hTfTNJNuXKSpywcbdvwRXpmK");
+
+    limited.maxOutstanding = 0;
+    BOOST_CHECK_THROW(Server server(limited), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()